@@ -0,0 +1,109 @@
+/*
+ * Expression evaluator benchmark: compiled expressions (expr_eval) against
+ * the native batched Rastrigin and Griewangk functions, evaluating batches of
+ * 1 + M points (forward and rotational positions of a shark) as the solver
+ * does, for several values of nd.
+ *
+ * Usage: bench/bench_expr [POINTS]
+ * Output: CSV with one line per (function, nd), the mean time per evaluation
+ * in nanoseconds of both versions, their ratio and the largest difference
+ * between their values.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../sso.h"
+
+#include "mpi.h"
+
+/* Values of nd */
+static const int nds[] = {2, 5, 20, 100};
+#define NUM_NDS (int)(sizeof(nds) / sizeof(nds[0]))
+
+/* Points per batch (1 + m_points of the test cases) */
+#define BATCH 21
+
+/* Functions */
+static const char *names[] = {"rastrigin", "griewangk"};
+static const char *exprs[] = {
+    "10 * nd + sum(i, x[i]^2 - 10 * cos(2 * pi * x[i]))",
+    "1 + sum(i, x[i]^2) / 4000 - prod(i, cos(x[i] / sqrt(i + 1)))"};
+static void (*natives[])(num_t *, int, int, int, num_t *) = {rastrigin_batch,
+                                                             griewangk_batch};
+
+int main(int argc, char *argv[])
+{
+    int points;
+    int f, i, p;
+    int nd;
+    num_t *X;
+    num_t *native_vals, *expr_vals;
+    num_t max_diff;
+    double t_native, t_expr;
+    struct expr_prog_s prog;
+    char err[EXPR_ERR_LEN];
+
+    MPI_Init(&argc, &argv);
+
+    points = argc > 1 ? atoi(argv[1]) : 1000000;
+    points = (points + BATCH - 1) / BATCH * BATCH;
+
+    printf("function,nd,native_ns,expr_ns,ratio,max_diff\n");
+
+    for (f = 0; f < 2; f++) {
+        for (i = 0; i < NUM_NDS; i++) {
+            nd = nds[i];
+            X = (num_t *)malloc((size_t)points * nd * sizeof(num_t));
+            native_vals = (num_t *)malloc(points * sizeof(num_t));
+            expr_vals = (num_t *)malloc(points * sizeof(num_t));
+            if (X == NULL || native_vals == NULL || expr_vals == NULL) {
+                printf("vector allocation error\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            rng_fill_uniform(1, 0, 0, 0, 0, points * nd, X);
+            for (p = 0; p < points * nd; p++) {
+                X[p] = 10 * X[p] - 5;
+            }
+
+            if (expr_compile(exprs[f], nd, MIN_GOAL, &prog, err,
+                             sizeof(err)) != 1) {
+                printf("%s: %s\n", names[f], err);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+
+            t_native = -MPI_Wtime();
+            for (p = 0; p < points; p += BATCH) {
+                natives[f](&X[(size_t)p * nd], BATCH, nd, nd, &native_vals[p]);
+            }
+            t_native += MPI_Wtime();
+
+            t_expr = -MPI_Wtime();
+            for (p = 0; p < points; p += BATCH) {
+                expr_eval(&prog, &X[(size_t)p * nd], BATCH, nd, &expr_vals[p]);
+            }
+            t_expr += MPI_Wtime();
+
+            max_diff = 0;
+            for (p = 0; p < points; p++) {
+                max_diff = MAX(max_diff, fabs(native_vals[p] - expr_vals[p]));
+            }
+
+            printf("%s,%d,%.2f,%.2f,%.2f,%.3e\n", names[f], nd,
+                   1e9 * t_native / points, 1e9 * t_expr / points,
+                   t_expr / t_native, max_diff);
+
+            expr_free(&prog);
+            free(X);
+            free(native_vals);
+            free(expr_vals);
+        }
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Solver kernel benchmark: specialized kernels (constant nd, objective
+ * function called directly) against the generic kernel, on every test case
+ * which has a specialized kernel. Each solve runs on a single process; the
+ * two kernels are run alternately and the fastest of REPS solves is kept.
+ *
+ * Usage: bench/bench_kernels [NP] [REPS]
+ * Output: CSV with one line per test case, the kernel, the time per shark
+ * step (one shark, one iteration) in nanoseconds of both kernels, the speedup
+ * and whether the best values found by the two kernels are identical.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../sso.h"
+
+#include "mpi.h"
+
+int main(int argc, char *argv[])
+{
+    int np, reps;
+    int tc, r, generic;
+    struct tc_params_s tc_params[NUM_OF_TC];
+    struct run_opts_s opts;
+    struct population_s pop = {0};
+    num_t *best_solution;
+    num_t best_val[2];
+    double t, best_t[2];
+    const char *name;
+
+    MPI_Init(&argc, &argv);
+
+    np = argc > 1 ? atoi(argv[1]) : 2000;
+    reps = argc > 2 ? atoi(argv[2]) : 5;
+
+    init_tc_params(tc_params);
+    init_run_opts(&opts);
+    opts.seed = 1;
+
+    printf("tc,kernel,generic_ns,specialized_ns,speedup,identical\n");
+
+    for (tc = 0; tc < NUM_OF_TC; tc++) {
+        if (select_kernel(&tc_params[tc], 0, &name) ==
+            select_kernel(&tc_params[tc], 1, NULL)) {
+            continue;
+        }
+
+        best_solution = (num_t *)malloc(tc_params[tc].nd * sizeof(num_t));
+        if (best_solution == NULL ||
+            population_alloc(&pop, np, tc_params[tc].nd, 0) == -1) {
+            printf("allocation error\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+
+        best_t[0] = best_t[1] = HUGE_VAL;
+        for (r = 0; r < reps; r++) {
+            for (generic = 0; generic < 2; generic++) {
+                opts.generic = generic;
+                pop.offset = 0;
+                pop.seed = opts.seed;
+                init_positions(&pop, tc_params[tc].low, tc_params[tc].high);
+
+                t = -MPI_Wtime();
+                compute_best_solution(tc_params[tc], &pop, &opts,
+                                      MPI_COMM_SELF, best_solution,
+                                      &best_val[generic], NULL);
+                t += MPI_Wtime();
+                best_t[generic] = MIN(best_t[generic], t);
+            }
+        }
+
+        t = 1e9 / ((double)np * tc_params[tc].k_max);
+        printf("%d,%s,%.2f,%.2f,%.3f,%s\n", tc, name, best_t[1] * t,
+               best_t[0] * t, best_t[1] / best_t[0],
+               best_val[0] == best_val[1] ? "yes" : "no");
+        fflush(stdout);
+
+        free(best_solution);
+    }
+
+    population_free(&pop);
+
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Final reduction benchmark: best solution vector and final statistics of
+ * every process reduced on MPI_COMM_WORLD (flat layout) against node shared
+ * memory (--shared: the results are combined by each node leader, then
+ * reduced among the leaders), for several values of nd.
+ *
+ * Usage: mpirun -n RANKS bench/bench_node [REPS]
+ * Output (process 0): CSV with one line per (nd, layout) and the mean time
+ * per final reduction in microseconds.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "../sso.h"
+
+#include "mpi.h"
+
+/* Values of nd */
+static const int nds[] = {2, 10, 100, 1000, 10000};
+#define NUM_NDS (int)(sizeof(nds) / sizeof(nds[0]))
+
+int main(int argc, char *argv[])
+{
+    int rank, size;
+    int nodes = 0;
+    int reps;
+    int i, j, r, a;
+    int nd;
+    void *arena;
+    num_t *local;
+    num_t *result;
+    struct node_s node;
+    struct node_stats_s stats, fin, res;
+    MPI_Datatype row_type;
+    MPI_Op min_op;
+    double t;
+    const char *names[2] = {"flat", "shared"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    reps = argc > 1 ? atoi(argv[1]) : 100;
+    MPI_Op_create((MPI_User_function *)&find_min_val, 1, &min_op);
+
+    stats.time_min = stats.time_max = stats.time_sum = rank;
+    stats.exchange_wait = rank;
+    stats.evals = stats.lookups = stats.cache_hits = stats.reused = rank;
+    stats.rss_max = stats.rss_sum = rank;
+    stats.target_iter = INT_MAX;
+    stats.iterations = stats.stop_reason = 0;
+
+    if (rank == 0) {
+        printf("ranks,nodes,nd,layout,time_us\n");
+    }
+
+    for (i = 0; i < NUM_NDS; i++) {
+        nd = nds[i];
+        local = (num_t *)malloc((nd + 1) * sizeof(num_t));
+        result = (num_t *)malloc((nd + 1) * sizeof(num_t));
+        if (local == NULL || result == NULL ||
+            node_init(&node, MPI_COMM_WORLD, nd, 0, &arena) == -1) {
+            printf("(%d): vector or window allocation error\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        if (rank == 0) {
+            MPI_Comm_size(node.leaders, &nodes);
+        }
+
+        MPI_Type_contiguous(nd + 1, NUM_DT, &row_type);
+        MPI_Type_commit(&row_type);
+
+        for (a = 0; a < 2; a++) {
+            t = 0;
+            for (r = 0; r < reps; r++) {
+                for (j = 0; j <= nd; j++) {
+                    local[j] = rank + j;
+                }
+                local[nd] = (rank * 7919) % size; /* the winner varies */
+                fin = stats;
+
+                MPI_Barrier(MPI_COMM_WORLD);
+                t -= MPI_Wtime();
+                if (a == 0) {
+                    MPI_Reduce(local, result, 1, row_type, min_op, 0,
+                               MPI_COMM_WORLD);
+                    node_stats_reduce(&fin, &res, MPI_COMM_WORLD);
+                } else {
+                    node_reduce(&node, MIN_GOAL, local, &fin);
+                    if (node.leaders != MPI_COMM_NULL) {
+                        MPI_Reduce(local, result, 1, row_type, min_op, 0,
+                                   node.leaders);
+                        node_stats_reduce(&fin, &res, node.leaders);
+                    }
+                }
+                t += MPI_Wtime();
+            }
+
+            /* Time of process 0 (root of both reductions) */
+            if (rank == 0) {
+                printf("%d,%d,%d,%s,%.3f\n", size, nodes, nd, names[a],
+                       1e6 * t / reps);
+            }
+        }
+
+        MPI_Type_free(&row_type);
+        node_free(&node);
+        free(local);
+        free(result);
+    }
+
+    MPI_Op_free(&min_op);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Best solution reduction benchmark: custom reduce operation on the whole
+ * (nd+1)-vector (find_min_val) against the (value, rank) MINLOC reduction
+ * followed by a single transfer of the winning vector (reduce_best,
+ * allreduce_best), for several values of nd.
+ *
+ * Usage: mpirun -n RANKS bench/bench_reduce [REPS]
+ * Output (process 0): CSV with one line per (nd, algorithm) and the mean time
+ * per call in microseconds.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../sso.h"
+
+#include "mpi.h"
+
+/* Values of nd */
+static const int nds[] = {2, 10, 100, 1000, 10000, 100000};
+#define NUM_NDS (int)(sizeof(nds) / sizeof(nds[0]))
+
+int main(int argc, char *argv[])
+{
+    int rank, size;
+    int reps;
+    int i, r, a;
+    int nd;
+    num_t *local;
+    num_t *result;
+    MPI_Datatype row_type;
+    MPI_Op min_op;
+    double t[4]; /* reduce op, reduce loc, allreduce op, allreduce loc */
+    const char *names[4] = {"reduce_op", "reduce_loc", "allreduce_op",
+                            "allreduce_loc"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    reps = argc > 1 ? atoi(argv[1]) : 100;
+    MPI_Op_create((MPI_User_function *)&find_min_val, 1, &min_op);
+
+    if (rank == 0) {
+        printf("ranks,nd,algorithm,time_us\n");
+    }
+
+    for (i = 0; i < NUM_NDS; i++) {
+        nd = nds[i];
+        local = (num_t *)malloc((nd + 1) * sizeof(num_t));
+        result = (num_t *)malloc((nd + 1) * sizeof(num_t));
+        if (local == NULL || result == NULL) {
+            printf("(%d): vector allocation error\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for (r = 0; r <= nd; r++) {
+            local[r] = rank + r;
+        }
+        local[nd] = (rank * 7919) % size; /* the winner is not always 0 */
+
+        MPI_Type_contiguous(nd + 1, NUM_DT, &row_type);
+        MPI_Type_commit(&row_type);
+
+        for (a = 0; a < 4; a++) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            t[a] = -MPI_Wtime();
+            for (r = 0; r < reps; r++) {
+                switch (a) {
+                case 0:
+                    MPI_Reduce(local, result, 1, row_type, min_op, 0,
+                               MPI_COMM_WORLD);
+                    break;
+                case 1:
+                    reduce_best(local, result, nd, MIN_GOAL, 0,
+                                MPI_COMM_WORLD);
+                    break;
+                case 2:
+                    MPI_Allreduce(local, result, 1, row_type, min_op,
+                                  MPI_COMM_WORLD);
+                    break;
+                default:
+                    allreduce_best(local, result, nd, MIN_GOAL,
+                                   MPI_COMM_WORLD);
+                }
+            }
+            t[a] += MPI_Wtime();
+            MPI_Allreduce(MPI_IN_PLACE, &t[a], 1, MPI_DOUBLE, MPI_MAX,
+                          MPI_COMM_WORLD);
+
+            if (rank == 0) {
+                printf("%d,%d,%s,%.3f\n", size, nd, names[a],
+                       1e6 * t[a] / reps);
+            }
+        }
+
+        MPI_Type_free(&row_type);
+        free(local);
+        free(result);
+    }
+
+    MPI_Op_free(&min_op);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Top-K reduction benchmark: the K best distinct solutions of NP random
+ * solutions spread over the processes, selected with the top-K reduce
+ * operation (K (nd + 1) values per message) against gathering every solution
+ * at process 0 with MPI_Gatherv and selecting them there, for several values
+ * of NP.
+ *
+ * Usage: mpirun -n RANKS bench/bench_topk [K] [ND] [DIST] [REPS]
+ * Output (process 0): CSV with one line per (NP, method), the mean time per
+ * selection in microseconds (local selection included), the bytes received
+ * by process 0 and whether the result is identical to the gathered one.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../sso.h"
+
+#include "mpi.h"
+
+/* Values of NP */
+static const int nps[] = {10000, 100000, 1000000};
+#define NUM_NPS (int)(sizeof(nps) / sizeof(nps[0]))
+
+/* Uniform number in [0, 1) (64-bit LCG, top bits) */
+static num_t lcg(uint64_t *s)
+{
+    *s = *s * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (num_t)((*s >> 11) * (1.0 / 9007199254740992.0));
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size;
+    int k, nd, reps;
+    num_t dist;
+    int row;        /* values per solution */
+    int np, np_local, first;
+    int i, j, r, p, a;
+    uint64_t s;
+    num_t *rows;    /* local solutions (np_local rows) */
+    num_t **X;      /* row pointers (local or gathered solutions) */
+    num_t *vals;    /* values (local or gathered solutions) */
+    num_t *all;     /* gathered solutions (process 0) */
+    int *counts, *displs;
+    num_t *gathered; /* gathered top-K list (process 0) */
+    struct topk_s t;
+    double time;
+    long long bytes;
+    int same;
+    const char *names[2] = {"gatherv", "topk"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    k = argc > 1 ? atoi(argv[1]) : 10;
+    nd = argc > 2 ? atoi(argv[2]) : 10;
+    dist = argc > 3 ? (num_t)atof(argv[3]) : 0;
+    reps = argc > 4 ? atoi(argv[4]) : 10;
+    row = nd + 1;
+
+    counts = (int *)malloc(size * sizeof(int));
+    displs = (int *)malloc(size * sizeof(int));
+    gathered = (num_t *)malloc((size_t)k * row * sizeof(num_t));
+    if (counts == NULL || displs == NULL || gathered == NULL ||
+        topk_init(&t, k, nd, dist) == -1) {
+        printf("(%d): memory allocation error\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (rank == 0) {
+        printf("ranks,np,k,nd,dist,method,time_us,root_bytes,same\n");
+    }
+
+    for (i = 0; i < NUM_NPS; i++) {
+        np = nps[i];
+        first = (rank * np) / size;
+        np_local = ((rank + 1) * np) / size - first;
+        for (p = 0; p < size; p++) {
+            displs[p] = (int)(((long long)p * np) / size * row);
+            counts[p] = (int)(((long long)(p + 1) * np) / size * row) -
+                        displs[p];
+        }
+
+        /* Solutions only depend on their global index; values are rounded
+         * to 1/1024 so that there are ties */
+        rows = (num_t *)malloc((size_t)MAX(np_local, 1) * row * sizeof(num_t));
+        X = (num_t **)malloc((size_t)np * sizeof(num_t *));
+        vals = (num_t *)malloc((size_t)np * sizeof(num_t));
+        all = rank == 0 ? (num_t *)malloc((size_t)np * row * sizeof(num_t))
+                        : NULL;
+        if (rows == NULL || X == NULL || vals == NULL ||
+            (rank == 0 && all == NULL)) {
+            printf("(%d): memory allocation error\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for (j = 0; j < np_local; j++) {
+            s = (uint64_t)(first + j) * 0x9e3779b97f4a7c15ULL + 1;
+            for (p = 0; p < nd; p++) {
+                rows[(size_t)j * row + p] = lcg(&s);
+            }
+            rows[(size_t)j * row + nd] = (int)(lcg(&s) * 1024) / 1024.0;
+        }
+
+        for (a = 0; a < 2; a++) {
+            time = 0;
+            for (r = 0; r < reps; r++) {
+                MPI_Barrier(MPI_COMM_WORLD);
+                time -= MPI_Wtime();
+                if (a == 0) {
+                    MPI_Gatherv(rows, np_local * row, NUM_DT, all, counts,
+                                displs, NUM_DT, 0, MPI_COMM_WORLD);
+                    if (rank == 0) {
+                        for (j = 0; j < np; j++) {
+                            X[j] = &all[(size_t)j * row];
+                            vals[j] = all[(size_t)j * row + nd];
+                        }
+                        if (topk_select(&t, X, vals, np) == -1) {
+                            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                        }
+                    }
+                } else {
+                    for (j = 0; j < np_local; j++) {
+                        X[j] = &rows[(size_t)j * row];
+                        vals[j] = rows[(size_t)j * row + nd];
+                    }
+                    if (topk_select(&t, X, vals, np_local) == -1) {
+                        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                    }
+                    MPI_Reduce(t.local, t.result, 1, t.type, t.op, 0,
+                               MPI_COMM_WORLD);
+                }
+                time += MPI_Wtime();
+            }
+
+            /* Time of process 0 (root of both methods) */
+            if (rank == 0) {
+                if (a == 0) {
+                    memcpy(gathered, t.local,
+                           (size_t)k * row * sizeof(num_t));
+                    bytes = (long long)(np - np_local) * row * sizeof(num_t);
+                    same = 1;
+                } else {
+                    /* binomial tree: one list per stage */
+                    for (p = 1, bytes = 0; p < size; p *= 2) {
+                        bytes += (long long)k * row * sizeof(num_t);
+                    }
+                    same = memcmp(gathered, t.result,
+                                  (size_t)k * row * sizeof(num_t)) == 0;
+                }
+                printf("%d,%d,%d,%d,%g,%s,%.3f,%lld,%d\n", size, np, k, nd,
+                       (double)dist, names[a], 1e6 * time / reps, bytes,
+                       same);
+                fflush(stdout);
+            }
+        }
+
+        free(rows);
+        free(X);
+        free(vals);
+        free(all);
+    }
+
+    topk_free(&t);
+    free(counts);
+    free(displs);
+    free(gathered);
+    MPI_Finalize();
+    return 0;
+}
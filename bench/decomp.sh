@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+# Decision variables decomposition benchmark.
+# For every test case in TCS and every number of decision variables in NDS,
+# run ./sso on RANKS processes REPS times with each group size in GROUPS (1:
+# population split only) and print one CSV row per configuration: median
+# elapsed time, objective function evaluations per second (at the median
+# time), largest peak resident set size of a process, best objective function
+# value and speedup with respect to the first group size.
+#
+# Usage: bench/decomp.sh [RANKS] [NP] [NDS] [TCS] [REPS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, GROUPS (default:
+# "1 2 RANKS")
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-4}
+NP=${2:-16}
+NDS=${3:-"10000 50000"}
+TCS=${4:-"4 6"}
+REPS=${5:-3}
+MPIRUN=${MPIRUN:-mpirun}
+GROUPS=${GROUPS:-"1 2 $RANKS"}
+SSO=$(dirname "$0")/../sso
+
+echo "tc,nd,np,ranks,group,reps,median_s,evals_per_s,max_rss_mib,best,speedup"
+for tc in $TCS; do
+    for nd in $NDS; do
+        base=
+        for group in $GROUPS; do
+            out=$(rep=0
+                while [ "$rep" -lt "$REPS" ]; do
+                    $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" --csv -s 1 \
+                        --nd "$nd" --decompose "$group" "$NP" "$tc" |
+                        grep '^csv,\|^Peak resident'
+                    rep=$((rep + 1))
+                done)
+            if [ -z "$out" ]; then
+                echo "$0: no output with groups of $group processes (TC" \
+                    "$tc, nd $nd)" >&2
+                continue
+            fi
+            median=$(echo "$out" | grep '^csv,' | cut -d, -f6 | sort -g |
+                awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }')
+            evals=$(echo "$out" | grep '^csv,' | head -n 1 | cut -d, -f7)
+            best=$(echo "$out" | grep '^csv,' | head -n 1 | cut -d, -f9)
+            rss=$(echo "$out" | grep '^Peak resident' | head -n 1 |
+                sed 's/.*max \([0-9.]*\),.*/\1/')
+            if [ -z "$base" ]; then
+                base=$median
+            fi
+            awk -v tc="$tc" -v nd="$nd" -v np="$NP" -v r="$RANKS" \
+                -v g="$group" -v n="$REPS" -v med="$median" -v ev="$evals" \
+                -v rss="$rss" -v best="$best" -v t0="$base" 'BEGIN {
+                    printf "%s,%s,%s,%s,%s,%s,%.6f,%.4e,%s,%s,%.3f\n", tc, nd,
+                        np, r, g, n, med, ev / med, rss, best, t0 / med
+                }'
+        done
+    done
+done
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Static vs dynamic distribution benchmark.
+# Run ./sso on test case TC (default: 8, variable evaluation cost) with the
+# static distribution and with the dynamic one for every chunk size, and
+# print the median total elapsed time and the median spread between the
+# fastest and the slowest process before the final reduction (time spent
+# idle by the fastest one).
+#
+# Usage: bench/dynamic.sh [RANKS] [NP] [TC] [CHUNKS] [REPS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-4}
+NP=${2:-64}
+TC=${3:-8}
+CHUNKS=${4:-"0 1 2 4 8"}
+REPS=${5:-5}
+MPIRUN=${MPIRUN:-mpirun}
+SSO=$(dirname "$0")/../sso
+
+median() {
+    sort -g | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+printf "%10s %12s %12s\n" chunk time_s idle_s
+for chunk in $CHUNKS; do
+    out=$(rep=0
+        while [ "$rep" -lt "$REPS" ]; do
+            $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" -s "$rep" -d "$chunk" \
+                "$NP" "$TC"
+            rep=$((rep + 1))
+        done)
+    time=$(echo "$out" | sed -n 's/^Total elapsed time (seconds): *//p' |
+        median)
+    idle=$(echo "$out" | awk '/^Time before final reduction/ {
+        print $NF - $7 }' | median)
+    printf "%10s %12.6f %12.6f\n" \
+        "$([ "$chunk" -eq 0 ] && echo static || echo "$chunk")" "$time" "$idle"
+done
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Global best exchange benchmark.
+# For every test case and exchange interval, run ./sso with SEEDS different
+# seeds and print how many runs reached the target (known optimum plus a
+# tolerance), the mean iterations to target over those runs and the mean
+# fraction of the exchange latency hidden behind computation.
+#
+# Usage: bench/exchange.sh [RANKS] [NP] [SEEDS] [INTERVALS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-4}
+NP=${2:-40}
+SEEDS=${3:-10}
+INTERVALS=${4:-"0 1 5"}
+MPIRUN=${MPIRUN:-mpirun}
+SSO=$(dirname "$0")/../sso
+
+# Target for each test case (known optimum plus tolerance)
+target() {
+    case $1 in
+    0) echo -0.999 ;;
+    1) echo 3.001 ;;
+    2) echo -3.001 ;;
+    *) echo 0.001 ;;
+    esac
+}
+
+printf "%4s %9s %8s %12s %9s\n" tc interval reached iterations hidden_%
+for tc in 0 1 2 3 4 5 6 7; do
+    for interval in $INTERVALS; do
+        seed=1
+        while [ "$seed" -le "$SEEDS" ]; do
+            $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" -s "$seed" \
+                -e "$interval" --target "$(target $tc)" "$NP" "$tc"
+            seed=$((seed + 1))
+        done | awk -v tc="$tc" -v e="$interval" -v runs="$SEEDS" '
+            /^Iterations to target/ { n++; it += $NF }
+            /latency hidden/ { h += $NF; nh++ }
+            END {
+                printf "%4d %9d %4d/%-3d %12s %9s\n", tc, e, n, runs,
+                       n ? sprintf("%.1f", it / n) : "-",
+                       nh ? sprintf("%.1f", h / nh) : "-"
+            }'
+    done
+done
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# Gradient estimator benchmark.
+# For every test case in TCS (Rastrigin and Griewangk) and number of decision
+# variables in NDS, run ./sso with SEEDS different seeds and each gradient
+# estimator in ESTS, stopping at the target (known optimum plus TARGET), and
+# print one CSV row per configuration: fraction of the runs which reached the
+# target, mean objective function evaluations and elapsed time (to the target,
+# or for the whole run) and mean best objective function value.
+#
+# Usage: bench/grad.sh [RANKS] [NP] [SEEDS] [NDS] [TCS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, ESTS (default:
+# analytic central forward spsa), TARGET (default: 0.001), DRAWS (SPSA draws,
+# default: 1), STEP (--grad-step, default: auto)
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-1}
+NP=${2:-200}
+SEEDS=${3:-5}
+NDS=${4:-"5 20"}
+TCS=${5:-"4 6"}
+MPIRUN=${MPIRUN:-mpirun}
+ESTS=${ESTS:-"analytic central forward spsa"}
+TARGET=${TARGET:-0.001}
+DRAWS=${DRAWS:-1}
+STEP=${STEP:-auto}
+SSO=$(dirname "$0")/../sso
+
+echo "tc,nd,estimator,np,reached,evals,time_s,best"
+for tc in $TCS; do
+    for nd in $NDS; do
+        for est in $ESTS; do
+            seed=1
+            while [ "$seed" -le "$SEEDS" ]; do
+                $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" --csv -s "$seed" \
+                    --nd "$nd" --grad "$est" --grad-step "$STEP" \
+                    --spsa-draws "$DRAWS" --target "$TARGET" --stop-target \
+                    "$NP" "$tc" | grep '^csv,\|^Iterations to target'
+                seed=$((seed + 1))
+            done | awk -F, -v tc="$tc" -v nd="$nd" -v est="$est" -v np="$NP" '
+                /^Iterations to target/ { r++; next }
+                { e += $7; t += $6; b += $9; n++ }
+                END {
+                    if (n > 0) {
+                        printf "%s,%s,%s,%s,%.2f,%.0f,%.6f,%e\n", tc, nd, est,
+                               np, r / n, e / n, t / n, b / n
+                    }
+                }'
+        done
+    done
+done
@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# Population layout benchmark.
+# For every test case in TCS and every population size in NPS, run ./sso on
+# RANKS processes REPS times with each layout in LAYOUTS ("aos", "soa",
+# "aos+huge", "soa+huge": --layout and --hugepages) and print one CSV row per
+# configuration: median elapsed time, objective function evaluations per
+# second (at the median time), best objective function value and speedup with
+# respect to the first layout.
+#
+# Usage: bench/layout.sh [RANKS] [NPS] [TCS] [REPS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, LAYOUTS (default:
+# "aos soa aos+huge soa+huge")
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-4}
+NPS=${2:-"10000 100000"}
+TCS=${3:-"1 4 6"}
+REPS=${4:-3}
+MPIRUN=${MPIRUN:-mpirun}
+LAYOUTS=${LAYOUTS:-"aos soa aos+huge soa+huge"}
+SSO=$(dirname "$0")/../sso
+
+echo "tc,np,ranks,layout,reps,median_s,evals_per_s,best,speedup"
+for tc in $TCS; do
+    for np in $NPS; do
+        base=
+        for layout in $LAYOUTS; do
+            flags="--layout ${layout%+huge}"
+            if [ "$layout" != "${layout%+huge}" ]; then
+                flags="$flags --hugepages"
+            fi
+            out=$(rep=0
+                while [ "$rep" -lt "$REPS" ]; do
+                    $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" --csv -s 1 \
+                        $flags "$np" "$tc" | grep '^csv,'
+                    rep=$((rep + 1))
+                done)
+            if [ -z "$out" ]; then
+                echo "$0: no output with layout $layout (TC $tc, NP $np)" >&2
+                continue
+            fi
+            median=$(echo "$out" | cut -d, -f6 | sort -g |
+                awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }')
+            evals=$(echo "$out" | head -n 1 | cut -d, -f7)
+            best=$(echo "$out" | head -n 1 | cut -d, -f9)
+            if [ -z "$base" ]; then
+                base=$median
+            fi
+            awk -v tc="$tc" -v np="$np" -v r="$RANKS" -v l="$layout" \
+                -v n="$REPS" -v med="$median" -v ev="$evals" -v best="$best" \
+                -v t0="$base" 'BEGIN {
+                    printf "%s,%s,%s,%s,%s,%.6f,%.4e,%s,%.3f\n", tc, np, r, l,
+                        n, med, ev / med, best, t0 / med
+                }'
+        done
+    done
+done
@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# Floating point precision benchmark.
+# For every test case, run the double (./sso), float (./sso_float) and mixed
+# precision (./sso_mixed) builds with SEEDS different seeds and print, for
+# each build, the mean elapsed time, the mean objective function evaluations
+# per second, and the mean and worst error of the best objective function
+# value with respect to the known optimum.
+# Build the three binaries with make precision.
+#
+# Usage: bench/precision.sh [RANKS] [NP] [SEEDS] [TCS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, BUILDS (default:
+# "double float mixed")
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-1}
+NP=${2:-2000}
+SEEDS=${3:-5}
+TCS=${4:-"0 1 2 3 4 5 6 7 8"}
+MPIRUN=${MPIRUN:-mpirun}
+BUILDS=${BUILDS:-"double float mixed"}
+DIR=$(dirname "$0")/..
+
+# Known optimum of each test case
+optimum() {
+    case $1 in
+    0) echo -1 ;;
+    1) echo 3 ;;
+    2) echo -3 ;;
+    *) echo 0 ;;
+    esac
+}
+
+# Binary of each build
+binary() {
+    case $1 in
+    double) echo "$DIR/sso" ;;
+    *) echo "$DIR/sso_$1" ;;
+    esac
+}
+
+echo "tc,build,seeds,time_s,evals_per_s,mean_error,max_error"
+for tc in $TCS; do
+    for build in $BUILDS; do
+        seed=1
+        while [ "$seed" -le "$SEEDS" ]; do
+            $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$(binary "$build")" --csv \
+                -s "$seed" "$NP" "$tc" | grep '^csv,'
+            seed=$((seed + 1))
+        done | awk -F, -v tc="$tc" -v b="$build" -v opt="$(optimum "$tc")" '{
+            e = $9 - opt; if (e < 0) e = -e
+            t += $6; ev += $8; err += e; if (e > max) max = e; n++ }
+            END { printf "%s,%s,%d,%.6f,%.4e,%.3e,%.3e\n", tc, b, n, t / n,
+                         ev / n, err / n, max }'
+    done
+done
@@ -0,0 +1,92 @@
+#!/bin/sh
+#
+# Strong and weak scaling benchmark.
+# For every test case in TCS and every population size in NPS, run ./sso
+# REPS times on each process count in RANKS and print one CSV row per
+# configuration: median, 10th and 90th percentile of the total elapsed time,
+# objective function evaluations per second (at the median time) and parallel
+# efficiency with respect to the first process count in RANKS.
+# Strong scaling keeps the population size fixed (efficiency:
+# T(r0) * r0 / (T(r) * r)); weak scaling runs NP sharks per process
+# (efficiency: T(r0) / T(r)).
+# If MIN_EFFICIENCY is set, the script exits with status 1 when any
+# efficiency is below it (regression check).
+#
+# Usage: bench/scaling.sh [RANKS] [NPS] [TCS] [REPS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, THREADS (threads per
+# process, default: 1), MODES (default: "strong weak"), MIN_EFFICIENCY
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-"1 2 4"}
+NPS=${2:-"256 1024"}
+TCS=${3:-"3 4 6 7"}
+REPS=${4:-5}
+MPIRUN=${MPIRUN:-mpirun}
+THREADS=${THREADS:-1}
+MODES=${MODES:-"strong weak"}
+SSO=$(dirname "$0")/../sso
+
+# Print the P-th percentile (nearest rank) of the values read from stdin
+percentile() {
+    sort -g | awk -v p="$1" '{ v[NR] = $1 } END {
+        i = int(p * NR / 100 + 0.999999); print v[i < 1 ? 1 : i] }'
+}
+
+status=0
+echo "mode,tc,np,ranks,threads,reps,median_s,p10_s,p90_s,evals_per_s,efficiency"
+for mode in $MODES; do
+    for tc in $TCS; do
+        for np in $NPS; do
+            base_ranks=
+            base_time=
+            for ranks in $RANKS; do
+                total_np=$np
+                if [ "$mode" = weak ]; then
+                    total_np=$((np * ranks))
+                fi
+                out=$(rep=0
+                    while [ "$rep" -lt "$REPS" ]; do
+                        $MPIRUN $MPIRUN_FLAGS -n "$ranks" "$SSO" --csv \
+                            -t "$THREADS" -s "$rep" "$total_np" "$tc" |
+                            grep '^csv,'
+                        rep=$((rep + 1))
+                    done)
+                if [ -z "$out" ]; then
+                    echo "$0: no output from $ranks processes (TC $tc," \
+                        "NP $total_np)" >&2
+                    status=1
+                    continue
+                fi
+                times=$(echo "$out" | cut -d, -f6)
+                median=$(echo "$times" | percentile 50)
+                p10=$(echo "$times" | percentile 10)
+                p90=$(echo "$times" | percentile 90)
+                evals=$(echo "$out" | head -n 1 | cut -d, -f7)
+                if [ -z "$base_ranks" ]; then
+                    base_ranks=$ranks
+                    base_time=$median
+                fi
+                line=$(awk -v m="$mode" -v tc="$tc" -v np="$total_np" \
+                    -v r="$ranks" -v t="$THREADS" -v n="$REPS" \
+                    -v med="$median" -v p10="$p10" -v p90="$p90" \
+                    -v ev="$evals" -v r0="$base_ranks" -v t0="$base_time" \
+                    'BEGIN {
+                        eff = (m == "weak") ? t0 / med : t0 * r0 / (med * r)
+                        printf "%s,%s,%s,%s,%s,%s,%.6f,%.6f,%.6f,%.4e,%.4f\n",
+                            m, tc, np, r, t, n, med, p10, p90, ev / med, eff
+                    }')
+                echo "$line"
+                if [ -n "$MIN_EFFICIENCY" ] &&
+                    awk -v e="${line##*,}" -v min="$MIN_EFFICIENCY" \
+                        'BEGIN { exit !(e < min) }'; then
+                    echo "$0: $mode scaling efficiency ${line##*,} below" \
+                        "$MIN_EFFICIENCY (TC $tc, NP $total_np, $ranks" \
+                        "processes)" >&2
+                    status=1
+                fi
+            done
+        done
+    done
+done
+exit $status
@@ -0,0 +1,47 @@
+#!/bin/sh
+#
+# Simulator worker pool benchmark.
+# For every artificial latency in LATENCIES, run ./sso on RANKS processes
+# with the stand-in simulator (sim/of_sim FUNC, nd ND) and each number of
+# workers per process in WORKERS, and print one CSV row per configuration:
+# elapsed time, objective function evaluations per second, best objective
+# function value and speedup with respect to the first number of workers.
+# Build the simulator with make sim/of_sim.
+#
+# Usage: bench/sim.sh [RANKS] [NP] [LATENCIES] [WORKERS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS, FUNC (default:
+# rastrigin), ND (default: 5), SEED (default: 1)
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-1}
+NP=${2:-20}
+LATENCIES=${3:-"0 100 1000"}
+WORKERS=${4:-"1 2 4 8"}
+MPIRUN=${MPIRUN:-mpirun}
+FUNC=${FUNC:-rastrigin}
+ND=${ND:-5}
+SEED=${SEED:-1}
+DIR=$(dirname "$0")/..
+
+echo "latency_us,workers,ranks,np,time_s,evals_per_s,best,speedup"
+for latency in $LATENCIES; do
+    base=
+    for workers in $WORKERS; do
+        out=$($MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$DIR/sso" --csv -s "$SEED" \
+            --sim "$DIR/sim/of_sim $FUNC $latency" --sim-workers "$workers" \
+            --nd "$ND" "$NP" | grep '^csv,')
+        if [ -z "$out" ]; then
+            echo "$0: no output with $workers workers (latency" \
+                "$latency us)" >&2
+            continue
+        fi
+        time=$(echo "$out" | cut -d, -f6)
+        if [ -z "$base" ]; then
+            base=$time
+        fi
+        echo "$out" | awk -F, -v l="$latency" -v w="$workers" -v t0="$base" '{
+            printf "%s,%s,%s,%s,%s,%s,%s,%.3f\n", l, w, $4, $3, $6, $8, $9,
+                t0 / $6 }'
+    done
+done
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Early termination benchmark.
+# For every test case, run ./sso with SEEDS different seeds with the fixed
+# iteration budget (k_max) and with early termination (stagnation window W,
+# relative improvement threshold TOL, and target: known optimum plus a
+# tolerance), and print the mean iterations run, the mean elapsed time of both
+# and the time saved, together with the mean best objective function value
+# reached by both.
+#
+# Usage: bench/stop.sh [RANKS] [NP] [SEEDS] [W] [TOL] [TCS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS
+#
+# (C) 2021 Giuseppe Vitolo
+
+RANKS=${1:-4}
+NP=${2:-400}
+SEEDS=${3:-5}
+W=${4:-5}
+TOL=${5:-1e-6}
+TCS=${6:-"0 1 2 3 4 5 6 7"}
+MPIRUN=${MPIRUN:-mpirun}
+SSO=$(dirname "$0")/../sso
+
+# Target for each test case (known optimum plus tolerance)
+target() {
+    case $1 in
+    0) echo -0.999 ;;
+    1) echo 3.001 ;;
+    2) echo -3.001 ;;
+    *) echo 0.001 ;;
+    esac
+}
+
+# Run all seeds and print "iterations time best" (means)
+runs() {
+    seed=1
+    while [ "$seed" -le "$SEEDS" ]; do
+        $MPIRUN $MPIRUN_FLAGS -n "$RANKS" "$SSO" --csv -s "$seed" "$@" |
+            grep '^csv,'
+        seed=$((seed + 1))
+    done | awk -F, '{ it += $10; t += $6; b += $9; n++ }
+        END { printf "%f %f %e\n", it / n, t / n, b / n }'
+}
+
+printf "%4s %10s %10s %10s %8s %13s %13s\n" tc iterations fixed_s \
+    stop_s saved_% best_fixed best_stop
+for tc in $TCS; do
+    fixed=$(runs "$NP" "$tc")
+    stop=$(runs --stop-window "$W" --stop-tol "$TOL" --target "$(target $tc)" \
+        --stop-target "$NP" "$tc")
+    echo "$fixed $stop" | awk -v tc="$tc" '{
+        printf "%4d %10.1f %10.6f %10.6f %8.1f %13.6e %13.6e\n", tc, $4, $2,
+               $5, 100 * (1 - $5 / $2), $3, $6 }'
+done
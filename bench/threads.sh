@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Ranks x threads scaling benchmark on a single node.
+# For every factorization CORES = ranks * threads, run ./sso REPS times and
+# print the median total elapsed time.
+#
+# Usage: bench/threads.sh [NP] [TC] [CORES] [REPS]
+# Environment: MPIRUN (default: mpirun), MPIRUN_FLAGS (e.g. "--bind-to none"
+# so that the threads of a rank are not bound to a single core).
+#
+# (C) 2021 Giuseppe Vitolo
+
+NP=${1:-10000}
+TC=${2:-6}
+CORES=${3:-$(nproc)}
+REPS=${4:-5}
+MPIRUN=${MPIRUN:-mpirun}
+SSO=$(dirname "$0")/../sso
+
+printf "%8s %8s %12s\n" ranks threads time_s
+ranks=1
+while [ "$ranks" -le "$CORES" ]; do
+    if [ $((CORES % ranks)) -eq 0 ]; then
+        threads=$((CORES / ranks))
+        rep=0
+        while [ "$rep" -lt "$REPS" ]; do
+            $MPIRUN $MPIRUN_FLAGS -n "$ranks" "$SSO" -t "$threads" "$NP" "$TC" |
+                sed -n 's/^Total elapsed time (seconds): *//p'
+            rep=$((rep + 1))
+        done | sort -g | awk -v r="$ranks" -v t="$threads" \
+            '{ v[NR] = $1 } END { printf "%8d %8d %12.6f\n", r, t, v[int((NR + 1) / 2)] }'
+    fi
+    ranks=$((ranks + 1))
+done
@@ -0,0 +1,193 @@
+/*
+ * Objective function evaluation cache.
+ *
+ * Each thread keeps a direct-mapped hash table of the last points it
+ * evaluated, keyed on their exact bits, between the generic solver kernel
+ * and the objective function. A batch of points is looked up first; the
+ * points not found are evaluated together with a single batched call, then
+ * stored (a point repeated in the same batch is only evaluated once). Values
+ * are only reused for bitwise identical points, so results do not change.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sso.h"
+
+/* Hash of the bits of a point (FNV-1a on 32-bit words, then mixed) */
+static uint64_t hash_point(const num_t *x, int nd)
+{
+    const unsigned char *b = (const unsigned char *)x;
+    size_t len = (size_t)nd * sizeof(num_t);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint32_t w;
+    size_t i;
+
+    for (i = 0; i < len; i += sizeof(w)) {
+        memcpy(&w, &b[i], sizeof(w));
+        h = (h ^ w) * 0x100000001b3ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * This function allocates an evaluation cache.
+ *
+ * Input parameters
+ * - nd: number of decision variables
+ * - slots: number of slots (rounded up to a power of two, 0: the cache is
+ *   disabled and eval_cached() calls the objective function directly)
+ * - batch: points looked up together (larger batches are split)
+ *
+ * Output parameters
+ * - c: evaluation cache (empty, counters cleared)
+ *
+ * Return value
+ * It returns -1 if a memory allocation error occurred.
+ * It returns 1 on success.
+ */
+int eval_cache_alloc(struct eval_cache_s *c, int nd, int slots, int batch)
+{
+    memset(c, 0, sizeof(*c));
+    c->nd = nd;
+    c->batch = batch;
+    if (slots <= 0) {
+        return 1;
+    }
+
+    c->slots = 1;
+    while (c->slots < slots) {
+        c->slots *= 2;
+    }
+
+    c->keys = (num_t *)malloc((size_t)c->slots * nd * sizeof(num_t));
+    c->vals = (num_t *)malloc(c->slots * sizeof(num_t));
+    c->state = (unsigned char *)calloc(c->slots, 1);
+    c->owner = (int *)malloc(c->slots * sizeof(int));
+    c->miss = (num_t *)malloc((size_t)batch * nd * sizeof(num_t));
+    c->miss_vals = (num_t *)malloc(batch * sizeof(num_t));
+    c->miss_slot = (int *)malloc(batch * sizeof(int));
+    c->src = (int *)malloc(batch * sizeof(int));
+    if (c->keys == NULL || c->vals == NULL || c->state == NULL ||
+        c->owner == NULL || c->miss == NULL || c->miss_vals == NULL ||
+        c->miss_slot == NULL || c->src == NULL) {
+        eval_cache_free(c);
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * This function frees an evaluation cache (the counters are kept).
+ *
+ * Input parameters
+ * - c: evaluation cache
+ */
+void eval_cache_free(struct eval_cache_s *c)
+{
+    free(c->keys);
+    free(c->vals);
+    free(c->state);
+    free(c->owner);
+    free(c->miss);
+    free(c->miss_vals);
+    free(c->miss_slot);
+    free(c->src);
+    c->keys = NULL;
+    c->vals = NULL;
+    c->state = NULL;
+    c->owner = NULL;
+    c->miss = NULL;
+    c->miss_vals = NULL;
+    c->miss_slot = NULL;
+    c->src = NULL;
+    c->slots = 0;
+}
+
+/*
+ * This function evaluates the objective function of a test case at n points
+ * through an evaluation cache.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - c: evaluation cache
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - c: points stored, counters updated
+ * - result: objective function values (length: n)
+ */
+void eval_cached(const struct tc_params_s *tc_params, struct eval_cache_s *c,
+                 num_t *X, int n, int ld, num_t *result)
+{
+    int nd = c->nd;
+    int first, len; /* current chunk of points */
+    int p, q, s;
+    int misses;
+    num_t *x;
+
+    if (c->slots == 0) {
+        eval_batch(tc_params, X, n, ld, result);
+        return;
+    }
+
+    for (first = 0; first < n; first += len) {
+        len = MIN(c->batch, n - first);
+
+        /* Look the points up; the slot of a point not found is claimed at
+         * once (CACHE_PENDING), so that a repetition in the chunk finds it */
+        misses = 0;
+        for (p = 0; p < len; p++) {
+            x = &X[(size_t)(first + p) * ld];
+            s = (int)(hash_point(x, nd) & (uint64_t)(c->slots - 1));
+
+            if (c->state[s] != CACHE_EMPTY &&
+                memcmp(&c->keys[(size_t)s * nd], x, nd * sizeof(num_t)) ==
+                    0) {
+                c->hits++;
+                if (c->state[s] == CACHE_VALID) {
+                    result[first + p] = c->vals[s];
+                    c->src[p] = -1;
+                } else {
+                    c->src[p] = c->owner[s];
+                }
+                continue;
+            }
+
+            memcpy(&c->miss[(size_t)misses * nd], x, nd * sizeof(num_t));
+            memcpy(&c->keys[(size_t)s * nd], x, nd * sizeof(num_t));
+            c->state[s] = CACHE_PENDING;
+            c->owner[s] = misses;
+            c->miss_slot[misses] = s;
+            c->src[p] = misses++;
+        }
+        c->lookups += len;
+
+        /* Evaluate the points not found, then store them (unless their slot
+         * was claimed again by a later point of the chunk) */
+        if (misses > 0) {
+            eval_batch(tc_params, c->miss, misses, nd, c->miss_vals);
+        }
+        for (q = 0; q < misses; q++) {
+            s = c->miss_slot[q];
+            if (c->state[s] == CACHE_PENDING && c->owner[s] == q) {
+                c->vals[s] = c->miss_vals[q];
+                c->state[s] = CACHE_VALID;
+            }
+        }
+        for (p = 0; p < len; p++) {
+            if (c->src[p] >= 0) {
+                result[first + p] = c->miss_vals[c->src[p]];
+            }
+        }
+    }
+}
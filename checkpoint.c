@@ -0,0 +1,289 @@
+/*
+ * Population checkpoint/restart with collective MPI-IO.
+ *
+ * A checkpoint holds a header (CKPT_H_*) followed by one record
+ * [X, V, best OF value] per shark in global shark order, so that it can be
+ * read back by any number of processes. The records are written with a
+ * non-blocking collective MPI_File_iwrite_at_all started at the end of an
+ * iteration and completed at the end of the next one, overlapping with the NP
+ * loop. Each checkpoint is written to "<path>.tmp", which is renamed to
+ * <path> once complete, so that a run killed while writing leaves the
+ * previous checkpoint intact. Random numbers only depend on the seed, on the
+ * shark index and on the iteration, so the seed and the iteration counter are
+ * the whole PRNG state.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/*
+ * This function initializes a checkpoint.
+ *
+ * Input parameters
+ * - comm: communicator (every process in comm writes its sharks)
+ * - path: checkpoint file
+ * - np: population size (all processes)
+ * - tc: test case
+ * - pop: local population (pop->offset is its first global shark index)
+ *
+ * Output parameters
+ * - ck: checkpoint
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int checkpoint_init(struct checkpoint_s *ck, MPI_Comm comm, const char *path,
+                    int np, int tc, const struct population_s *pop)
+{
+    ck->comm = comm;
+    ck->np = np;
+    ck->tc = tc;
+    ck->active = 0;
+    ck->count = 0;
+    ck->wait_time = 0;
+
+    ck->path = (char *)malloc(2 * strlen(path) + sizeof(".tmp") + 1);
+    ck->buf = (num_t *)malloc((size_t)MAX(pop->np, 1) * (2 * pop->nd + 1) *
+                              sizeof(num_t));
+    if (ck->path == NULL || ck->buf == NULL) {
+        free(ck->path);
+        free(ck->buf);
+        return -1;
+    }
+    strcpy(ck->path, path);
+    ck->tmp_path = ck->path + strlen(path) + 1;
+    sprintf(ck->tmp_path, "%s.tmp", path);
+
+    return 1;
+}
+
+/*
+ * This function starts a checkpoint of the current population: the records
+ * are packed and the non-blocking writes are started. Every process in
+ * ck->comm must call it at the same iteration.
+ *
+ * Input parameters
+ * - ck: checkpoint (no write in progress)
+ * - pop: population (pop->iter completed iterations)
+ *
+ * Return value
+ * It returns -1 if the file could not be opened.
+ * It returns 1 on success.
+ */
+int checkpoint_start(struct checkpoint_s *ck, const struct population_s *pop)
+{
+    int rec = 2 * pop->nd + 1; /* record length */
+    int rank;
+    int i;
+    MPI_Offset offset;
+
+    MPI_Comm_rank(ck->comm, &rank);
+
+    /* Pack the local records */
+    for (i = 0; i < pop->np; i++) {
+        memcpy(&ck->buf[(size_t)i * rec], pop->X[i], pop->nd * sizeof(num_t));
+        memcpy(&ck->buf[(size_t)i * rec + pop->nd], pop->V[i],
+               pop->nd * sizeof(num_t));
+        ck->buf[(size_t)i * rec + 2 * pop->nd] = pop->best_OF_vals[i];
+    }
+
+    ck->header[CKPT_H_MAGIC] = CKPT_MAGIC;
+    ck->header[CKPT_H_NUM_SIZE] = sizeof(num_t);
+    ck->header[CKPT_H_NP] = ck->np;
+    ck->header[CKPT_H_ND] = pop->nd;
+    ck->header[CKPT_H_TC] = ck->tc;
+    ck->header[CKPT_H_ITER] = pop->iter;
+    ck->header[CKPT_H_SEED] = (int64_t)pop->seed;
+
+    if (MPI_File_open(ck->comm, ck->tmp_path, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &ck->fh) != MPI_SUCCESS) {
+        return -1;
+    }
+    MPI_File_set_size(ck->fh, 0);
+
+    /* Process 0 writes the header, everyone writes its records */
+    ck->req[0] = MPI_REQUEST_NULL;
+    if (rank == 0) {
+        MPI_File_iwrite_at(ck->fh, 0, ck->header, CKPT_HEADER_LEN, MPI_INT64_T,
+                           &ck->req[0]);
+    }
+    offset = CKPT_HEADER_LEN * sizeof(int64_t) +
+             (MPI_Offset)pop->offset * rec * sizeof(num_t);
+    MPI_File_iwrite_at_all(ck->fh, offset, ck->buf, pop->np * rec, NUM_DT,
+                           &ck->req[1]);
+    ck->active = 1;
+
+    return 1;
+}
+
+/*
+ * This function lets MPI progress a checkpoint write.
+ *
+ * Input parameters
+ * - ck: checkpoint
+ */
+void checkpoint_progress(struct checkpoint_s *ck)
+{
+    int flag;
+
+    if (ck->active) {
+        MPI_Testall(2, ck->req, &flag, MPI_STATUSES_IGNORE);
+    }
+}
+
+/*
+ * This function completes the pending checkpoint (if any): it waits for the
+ * writes, closes the file and renames it. Every process in ck->comm must call
+ * it at the same iteration, and gets the same return value.
+ *
+ * Input parameters
+ * - ck: checkpoint
+ *
+ * Return value
+ * It returns -1 if the checkpoint could not be written.
+ * It returns 1 on success.
+ */
+int checkpoint_finish(struct checkpoint_s *ck)
+{
+    MPI_Status statuses[2];
+    int rank;
+    int ok;
+    double t;
+
+    if (!ck->active) {
+        return 1;
+    }
+
+    MPI_Comm_rank(ck->comm, &rank);
+
+    t = MPI_Wtime();
+    ok = MPI_Waitall(2, ck->req, statuses) == MPI_SUCCESS;
+    ok = MPI_File_close(&ck->fh) == MPI_SUCCESS && ok;
+    ck->wait_time += MPI_Wtime() - t;
+    ck->active = 0;
+
+    if (rank == 0 && ok) {
+        ok = rename(ck->tmp_path, ck->path) == 0;
+    }
+
+    /* Agree on the outcome (this also orders the rename before the next
+     * open of tmp_path) */
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, ck->comm);
+    if (!ok) {
+        return -1;
+    }
+    ck->count++;
+
+    return 1;
+}
+
+/*
+ * This function completes the pending checkpoint and frees a checkpoint.
+ *
+ * Input parameters
+ * - ck: checkpoint
+ *
+ * Return value
+ * It returns -1 if the pending checkpoint could not be written.
+ * It returns 1 on success.
+ */
+int checkpoint_free(struct checkpoint_s *ck)
+{
+    int status = checkpoint_finish(ck);
+
+    free(ck->path);
+    free(ck->buf);
+
+    return status;
+}
+
+/*
+ * This function reads a population from a checkpoint. Every process in comm
+ * reads its own sharks (global indices from pop->offset), so the number of
+ * processes may differ from the one which wrote the file.
+ *
+ * Input parameters
+ * - path: checkpoint file
+ * - comm: communicator
+ * - np: population size (all processes)
+ * - tc: test case
+ * - pop: population (allocated, pop->offset set)
+ *
+ * Output parameters
+ * - pop: positions, velocities, best values, iteration counter and seed
+ *
+ * Return value
+ * It returns -2 if the checkpoint does not match np, tc or pop->nd.
+ * It returns -1 if the file could not be read or a memory allocation problem
+ * occurred.
+ * It returns 1 on success.
+ */
+int checkpoint_read(const char *path, MPI_Comm comm, int np, int tc,
+                    struct population_s *pop)
+{
+    int64_t header[CKPT_HEADER_LEN];
+    int rec = 2 * pop->nd + 1; /* record length */
+    num_t *buf;
+    MPI_File fh;
+    MPI_Offset offset;
+    MPI_Status status;
+    int count; /* elements read */
+    int ok;
+    int i;
+
+    if (MPI_File_open(comm, (char *)path, MPI_MODE_RDONLY, MPI_INFO_NULL,
+                      &fh) != MPI_SUCCESS) {
+        return -1;
+    }
+
+    ok = MPI_File_read_at_all(fh, 0, header, CKPT_HEADER_LEN, MPI_INT64_T,
+                              &status) == MPI_SUCCESS;
+    if (ok) {
+        MPI_Get_count(&status, MPI_INT64_T, &count);
+    }
+    if (!ok || count != CKPT_HEADER_LEN || header[CKPT_H_MAGIC] != CKPT_MAGIC) {
+        MPI_File_close(&fh);
+        return -1;
+    }
+    if (header[CKPT_H_NUM_SIZE] != sizeof(num_t) || header[CKPT_H_NP] != np ||
+        header[CKPT_H_ND] != pop->nd || header[CKPT_H_TC] != tc) {
+        MPI_File_close(&fh);
+        return -2;
+    }
+
+    buf = (num_t *)malloc((size_t)MAX(pop->np, 1) * rec * sizeof(num_t));
+    ok = buf != NULL;
+
+    /* Collective call: processes without a buffer read nothing */
+    offset = CKPT_HEADER_LEN * sizeof(int64_t) +
+             (MPI_Offset)pop->offset * rec * sizeof(num_t);
+    ok = MPI_File_read_at_all(fh, offset, buf, ok ? pop->np * rec : 0, NUM_DT,
+                              &status) == MPI_SUCCESS && ok;
+    if (ok) {
+        MPI_Get_count(&status, NUM_DT, &count);
+        ok = count == pop->np * rec; /* truncated file */
+    }
+    MPI_File_close(&fh);
+
+    if (ok) {
+        for (i = 0; i < pop->np; i++) {
+            memcpy(pop->X[i], &buf[(size_t)i * rec], pop->nd * sizeof(num_t));
+            memcpy(pop->V[i], &buf[(size_t)i * rec + pop->nd],
+                   pop->nd * sizeof(num_t));
+            pop->best_OF_vals[i] = buf[(size_t)i * rec + 2 * pop->nd];
+        }
+        pop->iter = (int)header[CKPT_H_ITER];
+        pop->seed = (uint64_t)header[CKPT_H_SEED];
+    }
+    free(buf);
+
+    return ok ? 1 : -1;
+}
@@ -20,126 +20,279 @@
  *
  * Input parameters
  * - tc_params: test case parameters
- * - X: initial solution vectors (dimensions: np * nd)
- * - np: population size
+ * - pop: population (allocated with population_alloc() for tc_params.nd),
+ *   holding the initial solution vectors in pop->X. The
+ *   random numbers used by shark i only depend on pop->seed and on its global
+ *   index pop->offset + i.
+ * - opts: run options (exchange interval, target, kernel)
+ * - comm: communicator used for the global best exchange (every process in
+ *   comm must call this function with the same options; with pop->node the
+ *   exchange goes through the node shared window)
  *
  * Output parameters
+ * - pop: final population
  * - best_solution: optimal solution vector (length: nd)
  * - best_val: objective function value at best_solution
+ * - stats: run statistics (ignored if NULL)
  *
  * Return value
  * It returns -1 if a memory allocation problem occurred.
  * It returns 1 on success.
  */
-int compute_best_solution(struct tc_params_s tc_params, num_t **X, int np,
-                          num_t *best_solution, num_t *best_val)
+int compute_best_solution(struct tc_params_s tc_params,
+                          struct population_s *pop,
+                          const struct run_opts_s *opts, MPI_Comm comm,
+                          num_t *best_solution, num_t *best_val,
+                          struct run_stats_s *stats)
 {
-    num_t **V;              /* velocities */
-    num_t **Y;              /* next forward position */
-    num_t ***Z;             /* next rotational positions */
-    num_t *gradient_result; /* gradient */
-    num_t *best_OF_vals;    /* best values calculated from the OF */
+    num_t **X = pop->X;                      /* positions */
+    num_t **V = pop->V;                      /* velocities */
+    num_t *best_OF_vals = pop->best_OF_vals; /* best values from the OF */
+    int np = pop->np;                        /* population size */
     int i;                  /* iteration var [0,NP) */
     int j;                  /* iteration var [0,ND) */
     int k;                  /* iteration var [0,k_max) */
-    int m;                  /* # of points used in local search */
-    num_t R1;               /* random number between [0,1] */
-    num_t R2;               /* random number between [0,1] */
-    num_t R3;               /* random number between [-1,1] */
-    num_t velocities[2];    /* velocity (0) and velocity limit (1) */
-    int vel_limit_idx;      /* velocity limit index (0 or 1) */
+    num_t R1;               /* random number between [0,1) */
+    num_t R2;               /* random number between [0,1) */
     num_t current_OF_val;   /* used in loops to store OF value */
+    shark_step_t step = select_kernel(&tc_params,
+                                      opts->generic || opts->cache > 0,
+                                      NULL); /* solver kernel */
+    int status = 1;         /* return value (shared by all threads) */
+    struct exchange_s ex;   /* global best exchange */
+    int target_iter = -1;   /* iterations needed to reach the target */
+    int first_iter = pop->iter; /* first iteration (restart) */
+    struct checkpoint_s ck; /* population checkpoint */
+    struct stop_s st;       /* early termination */
+    int stop_enabled = opts->stop_window > 0 || opts->stop_target;
+    int stop_reason = STOP_NONE; /* STOP_* (shared by all threads) */
+    num_t target = 0;       /* target (internal, maximized OF value) */
 
-    /* Allocate space for V matrix */
-    if (allocate_2d_matrix(&V, np, tc_params.nd) == -1) {
-        return -1;
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(*stats));
     }
 
-    /* Allocate space for Y matrix */
-    if (allocate_2d_matrix(&Y, np, tc_params.nd) == -1) {
+    /* Set up the global best exchange */
+    if (opts->exchange > 0 &&
+        exchange_init(&ex, comm, pop->node, tc_params.nd, opts->reduce) == -1) {
         return -1;
     }
 
-    /* Allocate space for Z matrix */
-    if (allocate_3d_matrix(&Z, np, tc_params.m_points, tc_params.nd) == -1) {
+    /* Set up early termination (objective function values are maximized
+     * internally) */
+    if (stop_enabled &&
+        stop_init(&st, comm, opts->stop_window, opts->stop_tol,
+                  opts->stop_target, tc_params.goal * opts->target) == -1) {
+        if (opts->exchange > 0) {
+            exchange_free(&ex);
+        }
         return -1;
     }
 
-    /* Allocate space for best_OF_vals vector */
-    best_OF_vals = (num_t *)malloc(np * sizeof(num_t));
-    if (best_OF_vals == NULL) {
+    /* Set up the checkpoint */
+    if (opts->checkpoint != NULL &&
+        checkpoint_init(&ck, comm, opts->checkpoint, opts->np, opts->tc,
+                        pop) == -1) {
+        if (opts->exchange > 0) {
+            exchange_free(&ex);
+        }
+        if (stop_enabled) {
+            stop_free(&st);
+        }
         return -1;
     }
 
-    /* Allocate space for gradient_result vector */
-    gradient_result = (num_t *)malloc(tc_params.nd * sizeof(num_t));
-    if (gradient_result == NULL) {
-        return -1;
+    /* Objective function values are maximized internally */
+    if (opts->target_set) {
+        target = tc_params.goal * opts->target;
     }
 
-    /* Initialize velocities */
-    for (i = 0; i < np; i++) {
+    /* Initialize velocities (unless resuming from a checkpoint) */
+    for (i = 0; i < np && first_iter == 0; i++) {
         for (j = 0; j < tc_params.nd; j++) {
             V[i][j] = tc_params.initial_velocity;
         }
     }
 
-    for (k = 0; k < tc_params.k_max; k++) {
-        R1 = (num_t)rand() / RAND_MAX; /* [0,1] */
-        R2 = (num_t)rand() / RAND_MAX; /* [0,1] */
+    /* The NP loop is shared among the threads. Gradient and candidate buffers
+     * are thread-private and allocated once per solve: the candidate positions
+     * of a shark are generated, evaluated and compared in the same small
+     * buffer, so memory use does not depend on m_points. */
+#pragma omp parallel default(shared) private(i, k)
+    {
+        struct shark_ws_s ws = {0}; /* kernel workspace (this thread) */
+        int ws_ok;                  /* gradient workspace allocated */
+        int cache_ok;               /* evaluation cache allocated */
 
-        /* Each row is a solution of nd decision variables */
-        for (i = 0; i < np; i++) {
-            /* Compute gradient */
-            if (gradient(tc_params.obj_func, X[i], tc_params.nd,
-                         gradient_result) == -1) {
-                return -1;
-            }
+        /* Allocate space for the candidates (rows aligned like the
+         * population rows), gradient_result, cand_OF_vals and R3 vectors */
+        if (posix_memalign((void **)&ws.cand, CACHE_LINE,
+                           (1 + (size_t)tc_params.m_points) * pop->ld *
+                               sizeof(num_t)) != 0) {
+            ws.cand = NULL;
+        }
+        ws.gradient_result = (num_t *)malloc(tc_params.nd * sizeof(num_t));
+        ws.cand_OF_vals =
+            (num_t *)malloc((1 + tc_params.m_points) * sizeof(num_t));
+        ws.R3 = (num_t *)malloc(tc_params.m_points * sizeof(num_t));
 
-            /* Compute velocities and forward movement */
-            for (j = 0; j < tc_params.nd; j++) {
-                /* Compute new velocity */
-                velocities[0] = tc_params.eta * R1 * gradient_result[j] +
-                                tc_params.alpha * R2 * V[i][j];
+        /* Allocate the gradient workspace (stencil buffers are only needed
+         * by the numerical estimators) */
+        ws_ok = gradient_ws_alloc(&ws.grad, tc_params.nd,
+                                  tc_params.grad_est != GRAD_ANALYTIC
+                                      ? GRAD_BATCH
+                                      : 0) == 1;
 
-                /* Compute velocity limit */
-                velocities[1] = tc_params.beta * V[i][j];
+        /* Allocate the evaluation cache (batches: candidates or stencil) */
+        cache_ok = eval_cache_alloc(&ws.cache, tc_params.nd, opts->cache,
+                                    MAX(1 + tc_params.m_points,
+                                        GRAD_BATCH)) == 1;
+
+        if (ws.cand == NULL || ws.gradient_result == NULL ||
+            ws.cand_OF_vals == NULL ||
+            ws.R3 == NULL || !ws_ok || !cache_ok) {
+#pragma omp atomic write
+            status = -1;
+        }
 
-                /* Choose the velocity with the smallest abs value */
-                vel_limit_idx = min_abs(velocities[0], velocities[1]);
-                V[i][j] = velocities[vel_limit_idx];
+        /* Make sure that every thread sees the same status */
+#pragma omp barrier
+        PROF_START(ws.prof_t);
 
-                /* Set forward movement */
-                Y[i][j] = X[i][j] + V[i][j] * tc_params.delta_t;
+        for (k = first_iter;
+             k < tc_params.k_max && status == 1 && stop_reason == STOP_NONE;
+             k++) {
+#pragma omp single
+            {
+                R1 = rng_uniform(pop->seed, RNG_STREAM_GLOBAL, 0, k, 0);
+                R2 = rng_uniform(pop->seed, RNG_STREAM_GLOBAL, 0, k, 1);
             }
+            PROF_LAP(ws.prof, PROF_BARRIER, ws.prof_t, 0);
 
-            /* Set rotational movement positions (local search) */
-            for (m = 0; m < tc_params.m_points; m++) {
-                R3 = (num_t)rand() / RAND_MAX; /* [0,1] */
-                R3 = 2 * R3;                   /* [0,2] */
-                R3 = R3 - 1;                   /* [-1,1] */
+            /* Each row is a solution of nd decision variables */
+#pragma omp for schedule(static)
+            for (i = 0; i < np; i++) {
+                /* Let MPI progress the exchange (main thread only) */
+                if (opts->exchange > 0 && thread_num() == 0 &&
+                    i % EXCHANGE_POLL == 0) {
+                    exchange_progress(&ex);
+                    PROF_LAP(ws.prof, PROF_EXCHANGE, ws.prof_t, 0);
+                }
+                if (opts->checkpoint != NULL && thread_num() == 0 &&
+                    i % EXCHANGE_POLL == 0) {
+                    checkpoint_progress(&ck);
+                }
+                if (stop_enabled && thread_num() == 0 &&
+                    i % EXCHANGE_POLL == 0) {
+                    stop_progress(&st);
+                }
+
+                /* Move the shark */
+                step(&tc_params, pop, i, k, R1, R2, &ws);
+            } /* end NP loop */
+            PROF_LAP(ws.prof, PROF_BARRIER, ws.prof_t, 0);
+
+#pragma omp master
+            {
+                int last; /* last iteration */
 
-                for (j = 0; j < tc_params.nd; j++) {
-                    Z[i][m][j] = Y[i][j] + R3 * Y[i][j];
+                /* Complete the exchange started at the end of the previous
+                 * iteration */
+                if (opts->exchange > 0) {
+                    exchange_finish(&ex, pop);
+                }
+
+                if (opts->target_set && target_iter < 0 &&
+                    best_OF_vals[argmax(best_OF_vals, np)] >= target) {
+                    target_iter = k + 1;
                 }
-            }
 
-            /* Choose the best position for solution i among forward and
-             * rotational positions */
-            memcpy(X[i], Y[i], tc_params.nd * sizeof(num_t));
-            best_OF_vals[i] = tc_params.obj_func(Y[i], tc_params.nd);
+                /* Check the stopping criteria on the global best of the
+                 * previous iteration (every process takes the same decision)
+                 * and start the reduction for this one */
+                if (stop_enabled) {
+                    stop_reason = stop_update(
+                        &st, best_OF_vals[argmax(best_OF_vals, np)]);
+                }
+                last = k + 1 == tc_params.k_max || stop_reason != STOP_NONE;
 
-            for (m = 0; m < tc_params.m_points; m++) {
-                current_OF_val = tc_params.obj_func(Z[i][m], tc_params.nd);
+                /* Start a new exchange if it is due */
+                if (opts->exchange > 0 && (k + 1) % opts->exchange == 0 &&
+                    !last) {
+                    exchange_start(&ex, pop);
+                }
 
-                /* Compare current OF value with the best OF value stored */
-                if (current_OF_val > best_OF_vals[i]) {
-                    memcpy(X[i], Z[i][m], tc_params.nd * sizeof(num_t));
-                    best_OF_vals[i] = current_OF_val;
+                /* Complete the checkpoint started at the end of the previous
+                 * iteration, then start a new one if it is due */
+                pop->iter = k + 1;
+                if (opts->checkpoint != NULL &&
+                    (checkpoint_finish(&ck) == -1 ||
+                     ((k + 1) % opts->checkpoint_every == 0 && !last &&
+                      checkpoint_start(&ck, pop) == -1))) {
+                    status = -1;
                 }
+                PROF_LAP(ws.prof, PROF_EXCHANGE, ws.prof_t, 0);
+            }
+#pragma omp barrier
+            PROF_LAP(ws.prof, PROF_BARRIER, ws.prof_t, 0);
+        } /* end K_MAX loop */
+
+        if (stats != NULL) {
+#pragma omp critical
+            {
+                prof_merge(&stats->prof, &ws.prof);
+                stats->lookups += ws.cache.lookups;
+                stats->cache_hits += ws.cache.hits;
+                stats->reused += ws.cache.reused;
             }
-        } /* end NP loop */
-    }     /* end K_MAX loop */
+        }
+
+        /* Free heap space */
+        free(ws.cand);
+        free(ws.gradient_result);
+        free(ws.cand_OF_vals);
+        free(ws.R3);
+        if (ws_ok) {
+            gradient_ws_free(&ws.grad);
+        }
+        eval_cache_free(&ws.cache);
+    } /* end parallel region */
+
+    if (stats != NULL) {
+        stats->iterations = pop->iter;
+        stats->stop_reason = stop_reason;
+        stats->target_iter = target_iter;
+        stats->exchanges = opts->exchange > 0 ? ex.count : 0;
+        stats->exchange_wait = opts->exchange > 0 ? ex.wait_time : 0;
+        stats->exchange_flight = opts->exchange > 0 ? ex.flight_time : 0;
+        /* Each shark evaluates its forward and rotational positions, plus
+         * the points of the gradient estimator, except for the values reused
+         * or found in the evaluation cache */
+        stats->evals = (long long)np * (pop->iter - first_iter) *
+                           (1 + tc_params.m_points +
+                            gradient_evals(&tc_params)) -
+                       stats->cache_hits - stats->reused;
+    }
+
+    if (opts->exchange > 0) {
+        exchange_free(&ex);
+    }
+    if (stop_enabled) {
+        stop_free(&st);
+    }
+    if (opts->checkpoint != NULL) {
+        if (checkpoint_free(&ck) == -1) {
+            status = -1;
+        }
+        if (stats != NULL) {
+            stats->checkpoints = ck.count;
+            stats->checkpoint_wait = ck.wait_time;
+        }
+    }
+
+    if (status == -1) {
+        return -1;
+    }
 
     /* Choose the best solution among the NP solutions */
     memcpy(best_solution, X[0], tc_params.nd * sizeof(num_t));
@@ -158,12 +311,5 @@ int compute_best_solution(struct tc_params_s tc_params, num_t **X, int np,
      * to "flip" the value (since the OF returns -f(x) ) */
     *best_val = tc_params.goal * (*best_val);
 
-    /* Free heap space */
-    free_2d_matrix(&V, np);
-    free_2d_matrix(&Y, np);
-    free_3d_matrix(&Z, np, tc_params.m_points);
-    free(gradient_result);
-    free(best_OF_vals);
-
     return 1;
 }
@@ -0,0 +1,355 @@
+/*
+ * Decision variables decomposition.
+ *
+ * The processes are split into groups of opts->decompose consecutive
+ * processes. The population is split among the groups as in the static
+ * distribution, and the decision variables of the sharks of a group are split
+ * among its processes: each process stores, moves and differentiates its own
+ * slice of every shark of the group. The objective function must be
+ * decomposable (struct decomp_func_s): its value at a candidate is computed
+ * from the partial sums and products of the slices, reduced over the group for
+ * DECOMP_CHUNK sharks at a time, so that every process of the group knows the
+ * candidate values and chooses the same candidates. Random numbers only depend
+ * on the global shark and decision variable indices, as in the other
+ * distributions.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/*
+ * This function initializes the slice [j0, j0 + pop->nd) of the positions
+ * (same values as init_positions() on the whole vectors) and the velocities.
+ *
+ * Input parameters
+ * - pop: population slice (np, nd, offset and seed must be set)
+ * - tc_params: test case parameters
+ * - j0: index of the first decision variable of the slice
+ *
+ * Output parameters
+ * - pop: initial positions and velocities
+ */
+static void init_slice(struct population_s *pop,
+                       const struct tc_params_s *tc_params, int j0)
+{
+    int i, j;
+
+    pop->iter = 0;
+    for (i = 0; i < pop->np; i++) {
+        /* [0,1) */
+        rng_fill_uniform(pop->seed, RNG_STREAM_INIT,
+                         (uint32_t)(pop->offset + i), 0, (uint32_t)j0,
+                         pop->nd, pop->X[i]);
+
+        for (j = 0; j < pop->nd; j++) {
+            pop->X[i][j] = (tc_params->high - tc_params->low) * pop->X[i][j];
+            pop->X[i][j] = pop->X[i][j] + tc_params->low;
+            pop->V[i][j] = tc_params->initial_velocity;
+        }
+    }
+}
+
+/*
+ * This function computes the best solution of a population of np sharks whose
+ * decision variables are split among the processes of each group (see
+ * above). comm is split into groups of opts->decompose processes, which must
+ * divide its size; there must be at most np groups and at most nd processes
+ * per group.
+ *
+ * Input parameters
+ * - tc_params: test case parameters (decomp must be set)
+ * - opts: run options (opts->decompose is the group size)
+ * - np: population size
+ * - comm: communicator
+ *
+ * Output parameters
+ * - best_solution: best solution found by the group of this process (whole
+ *   vector, length: nd)
+ * - best_val: objective function value at best_solution
+ * - stats: run statistics (evaluations counted once per group)
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int run_decomposed(struct tc_params_s tc_params, const struct run_opts_s *opts,
+                   int np, MPI_Comm comm, num_t *best_solution,
+                   num_t *best_val, struct run_stats_s *stats)
+{
+    const struct decomp_func_s *f = tc_params.decomp;
+    struct population_s pop = {0}; /* sharks of the group, local slice */
+    MPI_Comm group_comm;    /* processes of the group */
+    MPI_Datatype pair_type; /* (S, P) pair */
+    MPI_Op sum_prod_op;     /* (S, P) pairs reduction */
+    int rank, size;
+    int g_size = opts->decompose; /* processes per group */
+    int groups;             /* number of groups */
+    int group;              /* group of this process */
+    int g_rank;             /* rank in the group */
+    int np_g;               /* sharks of the group */
+    int nd = tc_params.nd;
+    int j0, nj;             /* local slice of the decision variables */
+    int m_points = tc_params.m_points;
+    int i, k, r;
+    int c0, n;              /* first shark and number of sharks of a chunk */
+    int *counts, *displs;   /* slices of the processes of the group */
+    num_t *sp;              /* (S, P) pairs of the candidates of a chunk */
+    num_t *R3;              /* random numbers of the sharks of a chunk */
+    num_t *p_local;         /* local P of the sharks (np_g) */
+    num_t *p_all;           /* P of every slice (g_size * np_g) */
+    num_t *p_other;         /* P outside the local slice (np_g) */
+    num_t R1, R2;
+    int status = 1;         /* return value (shared by all threads) */
+    int target_iter = -1;   /* iterations needed to reach the target */
+    num_t target = 0;       /* target (internal, maximized OF value) */
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    memset(stats, 0, sizeof(*stats));
+
+    groups = size / g_size;
+    group = rank / g_size;
+    g_rank = rank % g_size;
+    MPI_Comm_split(comm, group, rank, &group_comm);
+
+    np_g = ((group + 1) * np) / groups - (group * np) / groups;
+    j0 = (g_rank * nd) / g_size;
+    nj = ((g_rank + 1) * nd) / g_size - j0;
+
+    counts = (int *)malloc(2 * g_size * sizeof(int));
+    sp = (num_t *)malloc(2 * DECOMP_CHUNK * (1 + (size_t)m_points) *
+                         sizeof(num_t));
+    R3 = (num_t *)malloc(DECOMP_CHUNK * (size_t)m_points * sizeof(num_t));
+    p_local = (num_t *)malloc((2 + (size_t)g_size) * np_g * sizeof(num_t));
+    if (counts == NULL || sp == NULL || R3 == NULL || p_local == NULL ||
+        population_alloc(&pop, np_g, nj, opts->pop_flags) == -1) {
+        free(counts);
+        free(sp);
+        free(R3);
+        free(p_local);
+        MPI_Comm_free(&group_comm);
+        return -1;
+    }
+    displs = counts + g_size;
+    p_all = p_local + np_g;
+    p_other = p_all + (size_t)g_size * np_g;
+
+    for (r = 0; r < g_size; r++) {
+        displs[r] = (r * nd) / g_size;
+        counts[r] = ((r + 1) * nd) / g_size - displs[r];
+    }
+
+    MPI_Type_contiguous(2, NUM_DT, &pair_type);
+    MPI_Type_commit(&pair_type);
+    MPI_Op_create((MPI_User_function *)&sum_prod, 1, &sum_prod_op);
+
+    pop.offset = (group * np) / groups;
+    pop.seed = opts->seed;
+    init_slice(&pop, &tc_params, j0);
+
+    /* Objective function values are maximized internally */
+    if (opts->target_set) {
+        target = tc_params.goal * opts->target;
+    }
+
+#pragma omp parallel default(shared) private(i, k, r, c0, n)
+    {
+        struct prof_s prof = {0}; /* per-phase profile (this thread) */
+        num_t *cand;            /* forward and rotational positions slices
+                                 * (1 + m_points rows, stride ld) */
+        num_t *gradient_result; /* gradient slice (nj) */
+        num_t *Y, *Z;
+        num_t velocities[2];    /* velocity (0) and velocity limit (1) */
+        num_t pair[2];          /* (S, P) pair */
+        num_t y;                /* forward position */
+        num_t val, best;
+        int j, m, q;
+        int ld = pop.ld;
+        PROF_VAR(prof_t);
+
+        if (posix_memalign((void **)&cand, CACHE_LINE,
+                           (1 + (size_t)m_points) * ld * sizeof(num_t)) != 0) {
+            cand = NULL;
+        }
+        gradient_result = (num_t *)malloc(nj * sizeof(num_t));
+        if (cand == NULL || gradient_result == NULL) {
+#pragma omp atomic write
+            status = -1;
+        }
+
+        /* Make sure that every thread sees the same status */
+#pragma omp barrier
+        PROF_START(prof_t);
+
+        for (k = 0; k < tc_params.k_max && status == 1; k++) {
+#pragma omp single
+            {
+                R1 = rng_uniform(pop.seed, RNG_STREAM_GLOBAL, 0, k, 0);
+                R2 = rng_uniform(pop.seed, RNG_STREAM_GLOBAL, 0, k, 1);
+            }
+
+            /* Product of the P of the other slices at the current positions
+             * (gradient of objective functions with a product term) */
+            if (f->prod) {
+#pragma omp for schedule(static)
+                for (i = 0; i < np_g; i++) {
+                    f->partial(pop.X[i], 1, ld, j0, nj, pair);
+                    p_local[i] = pair[1];
+                }
+                PROF_LAP(prof, PROF_GRADIENT, prof_t, 0);
+
+#pragma omp master
+                MPI_Allgather(p_local, np_g, NUM_DT, p_all, np_g, NUM_DT,
+                              group_comm);
+#pragma omp barrier
+                PROF_LAP(prof, PROF_EXCHANGE, prof_t, 0);
+
+#pragma omp for schedule(static)
+                for (i = 0; i < np_g; i++) {
+                    p_other[i] = 1;
+                    for (r = 0; r < g_size; r++) {
+                        if (r != g_rank) {
+                            p_other[i] *= p_all[(size_t)r * np_g + i];
+                        }
+                    }
+                }
+                PROF_LAP(prof, PROF_GRADIENT, prof_t, 0);
+            }
+
+            for (c0 = 0; c0 < np_g; c0 += DECOMP_CHUNK) {
+                n = MIN(DECOMP_CHUNK, np_g - c0);
+
+                /* Move the sharks of the chunk and compute the partial
+                 * objective function values of their candidates */
+#pragma omp for schedule(static)
+                for (i = c0; i < c0 + n; i++) {
+                    num_t *X = pop.X[i];
+                    num_t *V = pop.V[i];
+                    num_t *R3_i = &R3[(size_t)(i - c0) * m_points];
+
+                    f->grad(X, j0, nj, f->prod ? p_other[i] : 1,
+                            gradient_result);
+                    PROF_LAP(prof, PROF_GRADIENT, prof_t, 0);
+
+                    Y = cand;
+                    for (j = 0; j < nj; j++) {
+                        velocities[0] = tc_params.eta * R1 *
+                                            gradient_result[j] +
+                                        tc_params.alpha * R2 * V[j];
+                        velocities[1] = tc_params.beta * V[j];
+                        V[j] = velocities[min_abs(velocities[0],
+                                                  velocities[1])];
+                        Y[j] = X[j] + V[j] * tc_params.delta_t;
+                    }
+                    PROF_LAP(prof, PROF_UPDATE, prof_t, 0);
+
+                    rng_fill_uniform(pop.seed, RNG_STREAM_R3,
+                                     (uint32_t)(pop.offset + i), k, 0,
+                                     m_points, R3_i); /* [0,1) */
+                    for (m = 0; m < m_points; m++) {
+                        R3_i[m] = 2 * R3_i[m]; /* [0,2) */
+                        R3_i[m] = R3_i[m] - 1; /* [-1,1) */
+
+                        Z = cand + (size_t)(1 + m) * ld;
+                        for (j = 0; j < nj; j++) {
+                            Z[j] = Y[j] + R3_i[m] * Y[j];
+                        }
+                    }
+                    PROF_LAP(prof, PROF_ROTATE, prof_t, 0);
+
+                    f->partial(cand, 1 + m_points, ld, j0, nj,
+                               &sp[(size_t)2 * (i - c0) * (1 + m_points)]);
+                    PROF_LAP(prof, PROF_EVAL, prof_t,
+                             g_rank == 0 ? 1 + m_points : 0);
+                }
+
+                /* Combine the partial values of the whole group */
+#pragma omp master
+                MPI_Allreduce(MPI_IN_PLACE, sp, n * (1 + m_points), pair_type,
+                              sum_prod_op, group_comm);
+#pragma omp barrier
+                PROF_LAP(prof, PROF_EXCHANGE, prof_t, 0);
+
+                /* Choose the best position among forward and rotational
+                 * positions (the same on every process of the group), then
+                 * recompute its slice */
+#pragma omp for schedule(static)
+                for (i = c0; i < c0 + n; i++) {
+                    num_t *X = pop.X[i];
+                    num_t *V = pop.V[i];
+                    num_t *R3_i = &R3[(size_t)(i - c0) * m_points];
+                    num_t *sp_i = &sp[(size_t)2 * (i - c0) * (1 + m_points)];
+
+                    best = f->value(sp_i, nd);
+                    q = 0;
+                    for (m = 0; m < m_points; m++) {
+                        val = f->value(&sp_i[2 * (1 + m)], nd);
+                        if (val > best) {
+                            best = val;
+                            q = 1 + m;
+                        }
+                    }
+                    pop.best_OF_vals[i] = best;
+
+                    for (j = 0; j < nj; j++) {
+                        y = X[j] + V[j] * tc_params.delta_t;
+                        X[j] = q == 0 ? y : y + R3_i[q - 1] * y;
+                    }
+                    PROF_LAP(prof, PROF_SELECT, prof_t, 0);
+                }
+            } /* end chunk loop */
+
+#pragma omp master
+            {
+                if (opts->target_set && target_iter < 0 &&
+                    pop.best_OF_vals[argmax(pop.best_OF_vals, np_g)] >=
+                        target) {
+                    target_iter = k + 1;
+                }
+                pop.iter = k + 1;
+            }
+#pragma omp barrier
+            PROF_LAP(prof, PROF_BARRIER, prof_t, 0);
+        } /* end K_MAX loop */
+
+#pragma omp critical
+        prof_merge(&stats->prof, &prof);
+
+        free(cand);
+        free(gradient_result);
+    } /* end parallel region */
+
+    if (status == 1) {
+        /* Best shark of the group (the same on every process of the group):
+         * gather its slices */
+        i = argmax(pop.best_OF_vals, np_g);
+        MPI_Allgatherv(pop.X[i], nj, NUM_DT, best_solution, counts, displs,
+                       NUM_DT, group_comm);
+        *best_val = tc_params.goal * pop.best_OF_vals[i];
+
+        stats->iterations = pop.iter;
+        stats->stop_reason = STOP_NONE;
+        stats->target_iter = target_iter;
+        stats->evals =
+            g_rank == 0 ? (long long)np_g * pop.iter * (1 + m_points) : 0;
+    }
+
+    MPI_Op_free(&sum_prod_op);
+    MPI_Type_free(&pair_type);
+    MPI_Comm_free(&group_comm);
+    population_free(&pop);
+    free(counts);
+    free(sp);
+    free(R3);
+    free(p_local);
+
+    return status;
+}
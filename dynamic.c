@@ -0,0 +1,246 @@
+/*
+ * Dynamic load balancing: master/worker distribution of the population.
+ *
+ * Sharks do not interact with each other, so the population is split into
+ * chunks of consecutive sharks which are handed out on demand by process 0
+ * (master) to the other processes (workers). Each worker runs the whole
+ * optimization on a chunk, then moves to the next one; the master runs
+ * chunks too whenever no request is pending. Since the random
+ * numbers only depend on the global shark index, the result is the same as
+ * with the static distribution.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/* Message tags */
+#define TAG_REQUEST 1 /* worker -> master: request a chunk */
+#define TAG_CHUNK 2   /* master -> worker: first shark of a chunk (-1: stop) */
+
+/*
+ * This function runs the optimization on a chunk of sharks and merges the
+ * result with the best solution found so far.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - opts: run options
+ * - first: global index of the first shark
+ * - n: number of sharks
+ * - pop: population (its arena is reused between chunks)
+ * - best_solution: best solution found so far
+ * - best_val: best (internal, maximized) objective function value so far
+ * - stats: statistics so far
+ *
+ * Output parameters
+ * - pop, best_solution, best_val, stats: updated
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+static int run_chunk(struct tc_params_s tc_params,
+                     const struct run_opts_s *opts, int first, int n,
+                     struct population_s *pop, num_t *best_solution,
+                     num_t *best_val, struct run_stats_s *stats)
+{
+    struct run_stats_s chunk_stats;
+    num_t chunk_val;
+
+    if (population_alloc(pop, n, tc_params.nd, opts->pop_flags) == -1) {
+        return -1;
+    }
+    pop->offset = first;
+    pop->seed = opts->seed;
+    init_positions(pop, tc_params.low, tc_params.high);
+
+    if (compute_best_solution(tc_params, pop, opts, MPI_COMM_SELF,
+                              &best_solution[tc_params.nd + 1], &chunk_val,
+                              &chunk_stats) == -1) {
+        return -1;
+    }
+
+    /* compute_best_solution() returns goal * (internal value) */
+    chunk_val = tc_params.goal * chunk_val;
+    if (chunk_val > *best_val) {
+        memcpy(best_solution, &best_solution[tc_params.nd + 1],
+               tc_params.nd * sizeof(num_t));
+        *best_val = chunk_val;
+    }
+
+    stats->iterations = MAX(stats->iterations, chunk_stats.iterations);
+    stats->stop_reason = MAX(stats->stop_reason, chunk_stats.stop_reason);
+    if (chunk_stats.target_iter >= 0 &&
+        (stats->target_iter < 0 ||
+         chunk_stats.target_iter < stats->target_iter)) {
+        stats->target_iter = chunk_stats.target_iter;
+    }
+    stats->chunks++;
+    stats->evals += chunk_stats.evals;
+    stats->lookups += chunk_stats.lookups;
+    stats->cache_hits += chunk_stats.cache_hits;
+    stats->reused += chunk_stats.reused;
+    prof_merge(&stats->prof, &chunk_stats.prof);
+
+    return 1;
+}
+
+/*
+ * This function hands out chunks of sharks to the workers until the whole
+ * population has been distributed, then tells every worker to stop. Whenever
+ * no request is pending, the master runs the next chunk itself, so that its
+ * process is not left idle. Each worker keeps a request in flight (its next
+ * chunk), so it only waits for the reply if its chunk is done before the one
+ * of the master; the master starts computing once it has served two requests
+ * per worker (current and next chunk).
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - opts: run options (opts->dynamic is the chunk size)
+ * - np: population size
+ * - comm: communicator (master is process 0)
+ * - pop, best_solution, best_val, stats: see run_chunk()
+ *
+ * Output parameters
+ * - pop, best_solution, best_val, stats: updated
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+static int master(struct tc_params_s tc_params, const struct run_opts_s *opts,
+                  int np, MPI_Comm comm, struct population_s *pop,
+                  num_t *best_solution, num_t *best_val,
+                  struct run_stats_s *stats)
+{
+    int size;
+    int next = 0;    /* first shark of the next chunk */
+    int stopped = 0; /* workers told to stop */
+    int served = 0;  /* requests served */
+    int first;
+    int reply;
+    int pending;
+    int status = 1;
+    MPI_Status st;
+
+    MPI_Comm_size(comm, &size);
+
+    while (stopped < size - 1) {
+        /* Run a chunk when there is no request to serve */
+        MPI_Iprobe(MPI_ANY_SOURCE, TAG_REQUEST, comm, &pending, &st);
+        if (!pending && served >= 2 * (size - 1) && next < np &&
+            status == 1) {
+            first = next;
+            next += opts->dynamic;
+            status = run_chunk(tc_params, opts, first,
+                               MIN(opts->dynamic, np - first), pop,
+                               best_solution, best_val, stats);
+            continue;
+        }
+
+        MPI_Recv(NULL, 0, MPI_INT, pending ? st.MPI_SOURCE : MPI_ANY_SOURCE,
+                 TAG_REQUEST, comm, &st);
+        served++;
+
+        if (next < np) {
+            reply = next;
+            next += opts->dynamic;
+        } else {
+            reply = -1;
+            stopped++;
+        }
+
+        MPI_Send(&reply, 1, MPI_INT, st.MPI_SOURCE, TAG_CHUNK, comm);
+    }
+
+    return status;
+}
+
+/*
+ * This function computes the best solution of a population of np sharks whose
+ * chunks are dynamically distributed among the processes in comm. With a
+ * single process, every chunk is processed locally.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - opts: run options (opts->dynamic is the chunk size)
+ * - np: population size
+ * - comm: communicator
+ *
+ * Output parameters
+ * - best_solution: best solution found by this process (length: nd)
+ * - best_val: objective function value at best_solution (the worst possible
+ *   value if this process did not process any chunk)
+ * - stats: run statistics
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int run_dynamic(struct tc_params_s tc_params, const struct run_opts_s *opts,
+                int np, MPI_Comm comm, num_t *best_solution, num_t *best_val,
+                struct run_stats_s *stats)
+{
+    struct population_s pop = {0}; /* chunk population */
+    num_t *solution;    /* best solution, followed by scratch space */
+    num_t val = -HUGE_VAL; /* best internal objective function value */
+    int rank, size;
+    int first, next;    /* first shark of the current and next chunk */
+    int status = 1;
+    MPI_Request reqs[2];
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->target_iter = -1;
+
+    solution = (num_t *)calloc(2 * (tc_params.nd + 1), sizeof(num_t));
+    if (solution == NULL) {
+        return -1;
+    }
+
+    if (size == 1) {
+        for (first = 0; first < np && status == 1; first += opts->dynamic) {
+            status = run_chunk(tc_params, opts, first,
+                               MIN(opts->dynamic, np - first), &pop, solution,
+                               &val, stats);
+        }
+    } else if (rank == 0) {
+        status = master(tc_params, opts, np, comm, &pop, solution, &val,
+                        stats);
+    } else {
+        /* Keep one request in flight, so that the next chunk is already
+         * known when the current one is done */
+        MPI_Send(NULL, 0, MPI_INT, 0, TAG_REQUEST, comm);
+        MPI_Recv(&first, 1, MPI_INT, 0, TAG_CHUNK, comm, MPI_STATUS_IGNORE);
+
+        while (first >= 0) {
+            MPI_Isend(NULL, 0, MPI_INT, 0, TAG_REQUEST, comm, &reqs[0]);
+            MPI_Irecv(&next, 1, MPI_INT, 0, TAG_CHUNK, comm, &reqs[1]);
+
+            if (status == 1) {
+                status = run_chunk(tc_params, opts, first,
+                                   MIN(opts->dynamic, np - first), &pop,
+                                   solution, &val, stats);
+            }
+
+            MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+            first = next;
+        }
+    }
+
+    memcpy(best_solution, solution, tc_params.nd * sizeof(num_t));
+    *best_val = tc_params.goal * val;
+
+    population_free(&pop);
+    free(solution);
+
+    return status;
+}
@@ -0,0 +1,315 @@
+/*
+ * Periodic exchange of the global best solution between processes.
+ *
+ * The exchange is started at the end of an iteration with a non-blocking
+ * MPI_Iallreduce and completed at the end of the next one, so that the
+ * communication overlaps with the NP loop. The global best solution then
+ * replaces the worst local solution (if it is better).
+ * With REDUCE_OP the whole vector goes through the reduction (custom max
+ * operation). With REDUCE_LOC only the (value, rank) pair is reduced with
+ * MPI_MAXLOC, then the owner broadcasts the winning vector (MPI_Ibcast).
+ * With a node shared window (--shared) only the node leaders take part in the
+ * reduction: the processes of a node exchange their solutions through the
+ * window, synchronized with MPI_Ibarrier.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/*
+ * This function returns the index of the maximum value in a vector.
+ *
+ * Input parameters
+ * - v: vector
+ * - n: vector length
+ *
+ * Return value
+ * Index of the maximum value.
+ */
+int argmax(const num_t *v, int n)
+{
+    int i;
+    int idx = 0;
+
+    for (i = 1; i < n; i++) {
+        if (v[i] > v[idx]) {
+            idx = i;
+        }
+    }
+
+    return idx;
+}
+
+/*
+ * This function returns the index of the minimum value in a vector.
+ *
+ * Input parameters
+ * - v: vector
+ * - n: vector length
+ *
+ * Return value
+ * Index of the minimum value.
+ */
+int argmin(const num_t *v, int n)
+{
+    int i;
+    int idx = 0;
+
+    for (i = 1; i < n; i++) {
+        if (v[i] < v[idx]) {
+            idx = i;
+        }
+    }
+
+    return idx;
+}
+
+/*
+ * This function initializes an exchange. Objective function values are
+ * always maximized inside the solver, so the max reductions are used for every
+ * goal.
+ * With a node shared window the processes of each node publish their best
+ * solution in it, the node leader selects the best of the node and takes part
+ * in the reduction among the node leaders, then publishes the global best in
+ * the window, where the other processes of the node read it.
+ *
+ * Input parameters
+ * - comm: communicator (ignored with a node: the node leaders communicator
+ *   is used)
+ * - node: node shared window of the processes of comm (NULL: none)
+ * - nd: number of decision variables
+ * - reduce: REDUCE_OP / REDUCE_LOC
+ *
+ * Output parameters
+ * - ex: exchange
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int exchange_init(struct exchange_s *ex, MPI_Comm comm, struct node_s *node,
+                  int nd, int reduce)
+{
+    ex->comm = node != NULL ? node->leaders : comm;
+    ex->node = node;
+    ex->nd = nd;
+    ex->reduce = reduce;
+    ex->active = EXCHANGE_IDLE;
+    ex->count = 0;
+    ex->wait_time = 0;
+    ex->flight_time = 0;
+
+    ex->send = (num_t *)malloc(2 * (nd + 1) * sizeof(num_t));
+    if (ex->send == NULL) {
+        return -1;
+    }
+    ex->recv = ex->send + nd + 1;
+
+    MPI_Type_contiguous(nd + 1, NUM_DT, &ex->row_type);
+    MPI_Type_commit(&ex->row_type);
+    MPI_Op_create((MPI_User_function *)&find_max_val, 1, &ex->op);
+
+    return 1;
+}
+
+/*
+ * This function starts the non-blocking reduction of ex->send.
+ *
+ * Input parameters
+ * - ex: exchange
+ */
+static void reduce_start(struct exchange_s *ex)
+{
+    if (ex->reduce == REDUCE_LOC) {
+        MPI_Comm_rank(ex->comm, &ex->pair[0].rank);
+        ex->pair[0].val = ex->send[ex->nd];
+        MPI_Iallreduce(&ex->pair[0], &ex->pair[1], 1, NUM_INT_DT, MPI_MAXLOC,
+                       ex->comm, &ex->req);
+    } else {
+        MPI_Iallreduce(ex->send, ex->recv, 1, ex->row_type, ex->op, ex->comm,
+                       &ex->req);
+    }
+    ex->active = EXCHANGE_REDUCE;
+}
+
+/*
+ * This function starts an exchange: the best local solution is packed (with
+ * its objective function value in the last position) and the non-blocking
+ * reduction is started (with a node: the solution is published in the node
+ * window first).
+ *
+ * Input parameters
+ * - ex: exchange
+ * - pop: population
+ */
+void exchange_start(struct exchange_s *ex, struct population_s *pop)
+{
+    int best = argmax(pop->best_OF_vals, pop->np);
+    struct node_s *node = ex->node;
+
+    memcpy(ex->send, pop->X[best], ex->nd * sizeof(num_t));
+    ex->send[ex->nd] = pop->best_OF_vals[best];
+
+    ex->start_time = MPI_Wtime();
+    if (node != NULL) {
+        memcpy(&node->best[(size_t)node->rank * (ex->nd + 1)], ex->send,
+               (ex->nd + 1) * sizeof(num_t));
+        MPI_Win_sync(node->win);
+        MPI_Ibarrier(node->comm, &ex->req);
+        ex->active = EXCHANGE_GATHER;
+    } else {
+        reduce_start(ex);
+    }
+}
+
+/*
+ * This function moves an exchange whose pending request is complete to the
+ * next state:
+ * - EXCHANGE_GATHER: the node leader selects the best solution of the node
+ *   (ties: lowest node rank) and starts the reduction, the other processes
+ *   wait for the global best to be published;
+ * - EXCHANGE_REDUCE: with REDUCE_LOC the owner of the global best starts
+ *   broadcasting it;
+ * - EXCHANGE_REDUCE, EXCHANGE_BCAST: with a node the leader publishes the
+ *   global best;
+ * - EXCHANGE_PUBLISH: the other processes of the node read it.
+ *
+ * Input parameters
+ * - ex: exchange
+ */
+static void exchange_advance(struct exchange_s *ex)
+{
+    struct node_s *node = ex->node;
+    int nd = ex->nd;
+    num_t *row;
+    int i;
+
+    switch (ex->active) {
+    case EXCHANGE_GATHER:
+        MPI_Win_sync(node->win);
+        if (node->rank != 0) {
+            MPI_Ibarrier(node->comm, &ex->req);
+            ex->active = EXCHANGE_PUBLISH;
+            return;
+        }
+        for (i = 1; i < node->size; i++) {
+            row = &node->best[(size_t)i * (nd + 1)];
+            if (row[nd] > ex->send[nd]) {
+                memcpy(ex->send, row, (nd + 1) * sizeof(num_t));
+            }
+        }
+        reduce_start(ex);
+        return;
+    case EXCHANGE_REDUCE:
+        if (ex->reduce == REDUCE_LOC) {
+            if (ex->pair[1].rank == ex->pair[0].rank) {
+                memcpy(ex->recv, ex->send, (nd + 1) * sizeof(num_t));
+            }
+            MPI_Ibcast(ex->recv, nd + 1, NUM_DT, ex->pair[1].rank, ex->comm,
+                       &ex->req);
+            ex->active = EXCHANGE_BCAST;
+            return;
+        }
+        break;
+    case EXCHANGE_PUBLISH:
+        MPI_Win_sync(node->win);
+        if (node->rank != 0) {
+            memcpy(ex->recv, node->result, (nd + 1) * sizeof(num_t));
+        }
+        ex->active = EXCHANGE_COMPLETED;
+        return;
+    }
+
+    /* Global best in ex->recv */
+    if (node != NULL) {
+        memcpy(node->result, ex->recv, (nd + 1) * sizeof(num_t));
+        MPI_Win_sync(node->win);
+        MPI_Ibarrier(node->comm, &ex->req);
+        ex->active = EXCHANGE_PUBLISH;
+    } else {
+        ex->active = EXCHANGE_COMPLETED;
+    }
+}
+
+/*
+ * This function lets the MPI library progress an active exchange.
+ *
+ * Input parameters
+ * - ex: exchange
+ */
+void exchange_progress(struct exchange_s *ex)
+{
+    int flag;
+
+    while (ex->active != EXCHANGE_IDLE && ex->active != EXCHANGE_COMPLETED) {
+        MPI_Test(&ex->req, &flag, MPI_STATUS_IGNORE);
+        if (!flag) {
+            return;
+        }
+        exchange_advance(ex);
+    }
+}
+
+/*
+ * This function completes an active exchange and replaces the worst local
+ * solution with the global best one, unless the local population already
+ * contains an equal or better solution.
+ *
+ * Input parameters
+ * - ex: exchange
+ * - pop: population
+ *
+ * Output parameters
+ * - pop: updated population
+ */
+void exchange_finish(struct exchange_s *ex, struct population_s *pop)
+{
+    double t;
+    int worst;
+
+    if (ex->active == EXCHANGE_IDLE) {
+        return;
+    }
+
+    t = MPI_Wtime();
+    while (ex->active != EXCHANGE_COMPLETED) {
+        MPI_Wait(&ex->req, MPI_STATUS_IGNORE);
+        exchange_advance(ex);
+    }
+    ex->wait_time += MPI_Wtime() - t;
+    ex->flight_time += MPI_Wtime() - ex->start_time;
+    ex->active = EXCHANGE_IDLE;
+    ex->count++;
+
+    if (ex->recv[ex->nd] > pop->best_OF_vals[argmax(pop->best_OF_vals,
+                                                    pop->np)]) {
+        worst = argmin(pop->best_OF_vals, pop->np);
+        memcpy(pop->X[worst], ex->recv, ex->nd * sizeof(num_t));
+        pop->best_OF_vals[worst] = ex->recv[ex->nd];
+    }
+}
+
+/*
+ * This function frees the resources used by an exchange (an active exchange
+ * is completed first).
+ *
+ * Input parameters
+ * - ex: exchange
+ */
+void exchange_free(struct exchange_s *ex)
+{
+    while (ex->active != EXCHANGE_IDLE && ex->active != EXCHANGE_COMPLETED) {
+        MPI_Wait(&ex->req, MPI_STATUS_IGNORE);
+        exchange_advance(ex);
+    }
+
+    MPI_Type_free(&ex->row_type);
+    MPI_Op_free(&ex->op);
+    free(ex->send);
+}
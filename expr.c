@@ -0,0 +1,719 @@
+/*
+ * Objective functions from expressions.
+ *
+ * An expression is compiled by a recursive descent parser into a register
+ * based bytecode (constant subexpressions are folded and constant operands
+ * become immediates). Each register holds one value per point of a block of
+ * up to EXPR_LANES points, so every instruction is a tight loop over the
+ * block.
+ *
+ * Syntax:
+ *   expr    := term (('+' | '-') term)*
+ *   term    := unary (('*' | '/') unary)*
+ *   unary   := '-' unary | power
+ *   power   := primary ('^' unary)?
+ *   primary := NUMBER | 'pi' | 'nd' | VAR | 'x' '[' (INTEGER | VAR) ']'
+ *            | FUNC '(' expr ')' | ('sum' | 'prod') '(' VAR ',' expr ')'
+ *            | '(' expr ')'
+ * FUNC is one of sin, cos, tan, sqrt, exp, log, abs. sum(i, e) and
+ * prod(i, e) iterate i over the decision variables (0 to nd - 1); VAR is the
+ * index of an enclosing sum or prod. For example, the Rastrigin function is
+ *   10 * nd + sum(i, x[i]^2 - 10 * cos(2 * pi * x[i]))
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/* Opcodes */
+enum {
+    EX_CONST,  /* dst = c */
+    EX_LOADX,  /* dst = x[a] */
+    EX_LOADXI, /* dst = x[index of loop a] */
+    EX_INDEX,  /* dst = index of loop a */
+    EX_NEG,    /* dst = -a */
+    EX_ADD,    /* dst = a + b */
+    EX_SUB,    /* dst = a - b */
+    EX_MUL,    /* dst = a * b */
+    EX_DIV,    /* dst = a / b */
+    EX_POW,    /* dst = a ^ b */
+    EX_ADDC,   /* dst = a + c */
+    EX_RSUBC,  /* dst = c - a */
+    EX_MULC,   /* dst = a * c */
+    EX_DIVC,   /* dst = a / c */
+    EX_RDIVC,  /* dst = c / a */
+    EX_POWC,   /* dst = a ^ c */
+    EX_RPOWC,  /* dst = c ^ a */
+    EX_SQR,    /* dst = a * a */
+    EX_SIN,
+    EX_COS,
+    EX_TAN,
+    EX_SQRT,
+    EX_EXP,
+    EX_LOG,
+    EX_ABS,
+    EX_LOOP,   /* start loop a (skip to b if nd == 0) */
+    EX_ENDLOOP /* next index of loop a, back to b if any */
+};
+
+/* Functions (same order as EX_SIN..EX_ABS) */
+static const char *func_names[] = {"sin", "cos", "tan", "sqrt",
+                                   "exp", "log", "abs"};
+#define NUM_FUNCS (int)(sizeof(func_names) / sizeof(func_names[0]))
+
+/* parser operand struct: a register or a constant */
+struct operand_s {
+    int is_const; /* constant (no register) */
+    num_t c;      /* value (constant) */
+    int reg;      /* register (not constant) */
+};
+
+/* parser struct */
+struct parser_s {
+    const char *text;          /* expression */
+    const char *p;             /* current position */
+    struct expr_prog_s *prog;  /* program being compiled */
+    int cap;                   /* allocated instructions */
+    int top;                   /* first free register */
+    int loops;                 /* enclosing loops */
+    char vars[EXPR_MAX_LOOPS][EXPR_NAME_LEN]; /* loop variables */
+    char *err;                 /* error message */
+    size_t errlen;             /* error message size */
+    int status;                /* 1, -1 (memory) or -2 (syntax) */
+};
+
+/* Active program (scalar objective function ABI) */
+static const struct expr_prog_s *active_prog;
+
+static struct operand_s parse_expr(struct parser_s *ps);
+
+/* Record the first error */
+static void parse_error(struct parser_s *ps, const char *msg)
+{
+    if (ps->status == 1) {
+        snprintf(ps->err, ps->errlen, "%s at position %d", msg,
+                 (int)(ps->p - ps->text) + 1);
+        ps->status = -2;
+    }
+}
+
+/* Skip white space */
+static void skip_space(struct parser_s *ps)
+{
+    while (isspace((unsigned char)*ps->p)) {
+        ps->p++;
+    }
+}
+
+/* Consume character ch (after white space) if present */
+static int accept(struct parser_s *ps, char ch)
+{
+    skip_space(ps);
+    if (*ps->p == ch) {
+        ps->p++;
+        return 1;
+    }
+    return 0;
+}
+
+/* Consume character ch or record an error */
+static void expect(struct parser_s *ps, char ch)
+{
+    char msg[32];
+
+    if (!accept(ps, ch)) {
+        sprintf(msg, "expected '%c'", ch);
+        parse_error(ps, msg);
+    }
+}
+
+/* Read an identifier (empty if none) */
+static void identifier(struct parser_s *ps, char *name)
+{
+    int len = 0;
+
+    skip_space(ps);
+    while ((isalnum((unsigned char)*ps->p) || *ps->p == '_') &&
+           len < EXPR_NAME_LEN - 1) {
+        name[len++] = *ps->p++;
+    }
+    name[len] = '\0';
+}
+
+/* Loop slot of variable name (-1 if not an enclosing loop variable) */
+static int loop_var(struct parser_s *ps, const char *name)
+{
+    int l;
+
+    for (l = ps->loops - 1; l >= 0; l--) {
+        if (strcmp(ps->vars[l], name) == 0) {
+            return l;
+        }
+    }
+    return -1;
+}
+
+/* Append an instruction, return its index */
+static int emit(struct parser_s *ps, int op, int dst, int a, int b, num_t c)
+{
+    struct expr_insn_s *code;
+    struct expr_prog_s *prog = ps->prog;
+
+    if (ps->status != 1) {
+        return 0;
+    }
+    if (prog->n == ps->cap) {
+        code = (struct expr_insn_s *)realloc(
+            prog->code, 2 * MAX(ps->cap, 8) * sizeof(struct expr_insn_s));
+        if (code == NULL) {
+            ps->status = -1;
+            return 0;
+        }
+        prog->code = code;
+        ps->cap = 2 * MAX(ps->cap, 8);
+    }
+    code = &prog->code[prog->n];
+    code->op = op;
+    code->dst = dst;
+    code->a = a;
+    code->b = b;
+    code->c = c;
+
+    return prog->n++;
+}
+
+/* Allocate a register */
+static int new_reg(struct parser_s *ps)
+{
+    if (ps->top == EXPR_MAX_REGS) {
+        parse_error(ps, "expression too complex");
+        return 0;
+    }
+    ps->top++;
+    ps->prog->nregs = MAX(ps->prog->nregs, ps->top);
+    return ps->top - 1;
+}
+
+/* Put an operand in a register */
+static int to_reg(struct parser_s *ps, struct operand_s *v)
+{
+    if (v->is_const) {
+        v->reg = new_reg(ps);
+        v->is_const = 0;
+        emit(ps, EX_CONST, v->reg, 0, 0, v->c);
+    }
+    return v->reg;
+}
+
+/* Constant operand */
+static struct operand_s constant(num_t c)
+{
+    struct operand_s v = {1, c, 0};
+    return v;
+}
+
+/* Apply a binary operator ('+', '-', '*', '/', '^'), folding constants and
+ * using immediate operands */
+static struct operand_s binary(struct parser_s *ps, char op,
+                               struct operand_s l, struct operand_s r)
+{
+    static const int reg_ops[] = {EX_ADD, EX_SUB, EX_MUL, EX_DIV, EX_POW};
+    static const char ops[] = "+-*/^";
+    int k = (int)(strchr(ops, op) - ops);
+
+    if (l.is_const && r.is_const) {
+        switch (op) {
+        case '+': return constant(l.c + r.c);
+        case '-': return constant(l.c - r.c);
+        case '*': return constant(l.c * r.c);
+        case '/': return constant(l.c / r.c);
+        default: return constant(pow(l.c, r.c));
+        }
+    }
+
+    if (r.is_const) {
+        /* register op constant */
+        switch (op) {
+        case '+': emit(ps, EX_ADDC, l.reg, l.reg, 0, r.c); break;
+        case '-': emit(ps, EX_ADDC, l.reg, l.reg, 0, -r.c); break;
+        case '*': emit(ps, EX_MULC, l.reg, l.reg, 0, r.c); break;
+        case '/': emit(ps, EX_DIVC, l.reg, l.reg, 0, r.c); break;
+        default:
+            if (r.c == 2) {
+                emit(ps, EX_SQR, l.reg, l.reg, 0, 0);
+            } else {
+                emit(ps, EX_POWC, l.reg, l.reg, 0, r.c);
+            }
+        }
+        return l;
+    }
+
+    if (l.is_const) {
+        /* constant op register (r is the top register) */
+        switch (op) {
+        case '+': emit(ps, EX_ADDC, r.reg, r.reg, 0, l.c); break;
+        case '-': emit(ps, EX_RSUBC, r.reg, r.reg, 0, l.c); break;
+        case '*': emit(ps, EX_MULC, r.reg, r.reg, 0, l.c); break;
+        case '/': emit(ps, EX_RDIVC, r.reg, r.reg, 0, l.c); break;
+        default: emit(ps, EX_RPOWC, r.reg, r.reg, 0, l.c);
+        }
+        return r;
+    }
+
+    /* register op register (r is the top register) */
+    emit(ps, reg_ops[k], l.reg, l.reg, r.reg, 0);
+    ps->top = l.reg + 1;
+    return l;
+}
+
+/* sum(VAR, expr) and prod(VAR, expr) */
+static struct operand_s parse_loop(struct parser_s *ps, int is_sum)
+{
+    struct operand_s acc, body;
+    int loop;  /* EX_LOOP instruction */
+    int start; /* first instruction of the body */
+
+    expect(ps, '(');
+    if (ps->loops == EXPR_MAX_LOOPS) {
+        parse_error(ps, "too many nested loops");
+        return constant(0);
+    }
+    identifier(ps, ps->vars[ps->loops]);
+    if (ps->vars[ps->loops][0] == '\0') {
+        parse_error(ps, "expected loop variable");
+        return constant(0);
+    }
+    expect(ps, ',');
+
+    acc = constant(is_sum ? 0 : 1);
+    to_reg(ps, &acc);
+    loop = emit(ps, EX_LOOP, 0, ps->loops, 0, 0);
+    start = ps->prog->n;
+    ps->loops++;
+
+    body = parse_expr(ps);
+    if (body.is_const) {
+        emit(ps, is_sum ? EX_ADDC : EX_MULC, acc.reg, acc.reg, 0, body.c);
+    } else {
+        emit(ps, is_sum ? EX_ADD : EX_MUL, acc.reg, acc.reg, body.reg, 0);
+    }
+    ps->top = acc.reg + 1;
+
+    ps->loops--;
+    emit(ps, EX_ENDLOOP, 0, ps->loops, start, 0);
+    if (ps->status == 1) {
+        ps->prog->code[loop].b = ps->prog->n;
+    }
+    expect(ps, ')');
+
+    return acc;
+}
+
+/* primary := NUMBER | 'pi' | 'nd' | VAR | x[...] | FUNC(expr) | loop | (expr)
+ */
+static struct operand_s parse_primary(struct parser_s *ps)
+{
+    char name[EXPR_NAME_LEN];
+    char *end;
+    struct operand_s v;
+    long idx;
+    int f, l;
+
+    skip_space(ps);
+    if (isdigit((unsigned char)*ps->p) || *ps->p == '.') {
+        v = constant((num_t)strtod(ps->p, &end));
+        ps->p = end;
+        return v;
+    }
+    if (accept(ps, '(')) {
+        v = parse_expr(ps);
+        expect(ps, ')');
+        return v;
+    }
+
+    identifier(ps, name);
+    if (name[0] == '\0') {
+        parse_error(ps, "unexpected character");
+        return constant(0);
+    }
+    if (strcmp(name, "pi") == 0) {
+        return constant(M_PI);
+    }
+    if (strcmp(name, "nd") == 0) {
+        return constant(ps->prog->nd);
+    }
+    if (strcmp(name, "sum") == 0 || strcmp(name, "prod") == 0) {
+        return parse_loop(ps, name[0] == 's');
+    }
+    if (strcmp(name, "x") == 0) {
+        expect(ps, '[');
+        skip_space(ps);
+        v.is_const = 0;
+        if (isdigit((unsigned char)*ps->p)) {
+            idx = strtol(ps->p, &end, 10);
+            ps->p = end;
+            if (idx >= ps->prog->nd) {
+                parse_error(ps, "decision variable index out of range");
+            }
+            v.reg = new_reg(ps);
+            emit(ps, EX_LOADX, v.reg, (int)MIN(idx, ps->prog->nd), 0, 0);
+        } else {
+            identifier(ps, name);
+            l = loop_var(ps, name);
+            if (l < 0) {
+                parse_error(ps, "expected index or loop variable");
+            }
+            v.reg = new_reg(ps);
+            emit(ps, EX_LOADXI, v.reg, l, 0, 0);
+        }
+        expect(ps, ']');
+        return v;
+    }
+    for (f = 0; f < NUM_FUNCS; f++) {
+        if (strcmp(name, func_names[f]) == 0) {
+            expect(ps, '(');
+            v = parse_expr(ps);
+            expect(ps, ')');
+            if (v.is_const) {
+                switch (EX_SIN + f) {
+                case EX_SIN: return constant(sin(v.c));
+                case EX_COS: return constant(cos(v.c));
+                case EX_TAN: return constant(tan(v.c));
+                case EX_SQRT: return constant(sqrt(v.c));
+                case EX_EXP: return constant(exp(v.c));
+                case EX_LOG: return constant(log(v.c));
+                default: return constant(fabs(v.c));
+                }
+            }
+            emit(ps, EX_SIN + f, v.reg, v.reg, 0, 0);
+            return v;
+        }
+    }
+    l = loop_var(ps, name);
+    if (l < 0) {
+        parse_error(ps, "unknown identifier");
+        return constant(0);
+    }
+    v.is_const = 0;
+    v.reg = new_reg(ps);
+    emit(ps, EX_INDEX, v.reg, l, 0, 0);
+    return v;
+}
+
+/* power := primary ('^' unary)? */
+static struct operand_s parse_unary(struct parser_s *ps);
+
+static struct operand_s parse_power(struct parser_s *ps)
+{
+    struct operand_s v = parse_primary(ps);
+
+    if (accept(ps, '^')) {
+        v = binary(ps, '^', v, parse_unary(ps));
+    }
+    return v;
+}
+
+/* unary := '-' unary | power */
+static struct operand_s parse_unary(struct parser_s *ps)
+{
+    struct operand_s v;
+
+    if (accept(ps, '-')) {
+        v = parse_unary(ps);
+        if (v.is_const) {
+            return constant(-v.c);
+        }
+        emit(ps, EX_NEG, v.reg, v.reg, 0, 0);
+        return v;
+    }
+    return parse_power(ps);
+}
+
+/* term := unary (('*' | '/') unary)* */
+static struct operand_s parse_term(struct parser_s *ps)
+{
+    struct operand_s v = parse_unary(ps);
+
+    for (;;) {
+        if (accept(ps, '*')) {
+            v = binary(ps, '*', v, parse_unary(ps));
+        } else if (accept(ps, '/')) {
+            v = binary(ps, '/', v, parse_unary(ps));
+        } else {
+            return v;
+        }
+    }
+}
+
+/* expr := term (('+' | '-') term)* */
+static struct operand_s parse_expr(struct parser_s *ps)
+{
+    struct operand_s v = parse_term(ps);
+
+    for (;;) {
+        if (accept(ps, '+')) {
+            v = binary(ps, '+', v, parse_term(ps));
+        } else if (accept(ps, '-')) {
+            v = binary(ps, '-', v, parse_term(ps));
+        } else {
+            return v;
+        }
+    }
+}
+
+/*
+ * This function compiles an expression. Objective function values are always
+ * maximized inside the solver, so the compiled program computes -f(x) for
+ * minimization.
+ *
+ * Input parameters
+ * - text: expression
+ * - nd: number of decision variables
+ * - goal: MIN_GOAL / MAX_GOAL
+ * - errlen: size of err
+ *
+ * Output parameters
+ * - prog: compiled program (free with expr_free())
+ * - err: error message (syntax errors)
+ *
+ * Return value
+ * It returns -2 if the expression is not valid.
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int expr_compile(const char *text, int nd, int goal, struct expr_prog_s *prog,
+                 char *err, size_t errlen)
+{
+    struct parser_s ps;
+    struct operand_s v;
+
+    prog->nd = nd;
+    prog->n = 0;
+    prog->nregs = 1;
+    prog->code = NULL;
+
+    ps.text = text;
+    ps.p = text;
+    ps.prog = prog;
+    ps.cap = 0;
+    ps.top = 0;
+    ps.loops = 0;
+    ps.err = err;
+    ps.errlen = errlen;
+    ps.status = 1;
+
+    v = parse_expr(&ps);
+    skip_space(&ps);
+    if (*ps.p != '\0') {
+        parse_error(&ps, "unexpected character");
+    }
+    if (goal == MIN_GOAL) {
+        v = binary(&ps, '*', v, constant(-1));
+    }
+    to_reg(&ps, &v); /* the result is in register 0 */
+
+    if (ps.status != 1) {
+        expr_free(prog);
+    }
+    return ps.status;
+}
+
+/*
+ * This function broadcasts a compiled program.
+ *
+ * Input parameters
+ * - prog: program (significant at root only)
+ * - root: rank of the process which compiled it
+ * - comm: communicator
+ *
+ * Output parameters
+ * - prog: program (free with expr_free())
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int expr_bcast(struct expr_prog_s *prog, int root, MPI_Comm comm)
+{
+    int header[3];
+    int rank;
+
+    MPI_Comm_rank(comm, &rank);
+
+    header[0] = prog->nd;
+    header[1] = prog->n;
+    header[2] = prog->nregs;
+    MPI_Bcast(header, 3, MPI_INT, root, comm);
+
+    if (rank != root) {
+        prog->nd = header[0];
+        prog->n = header[1];
+        prog->nregs = header[2];
+        prog->code = (struct expr_insn_s *)malloc(
+            MAX(prog->n, 1) * sizeof(struct expr_insn_s));
+        if (prog->code == NULL) {
+            return -1;
+        }
+    }
+
+    /* Every process runs the same executable */
+    MPI_Bcast(prog->code, prog->n * (int)sizeof(struct expr_insn_s), MPI_BYTE,
+              root, comm);
+
+    return 1;
+}
+
+/*
+ * This function frees a compiled program.
+ *
+ * Input parameters
+ * - prog: program
+ */
+void expr_free(struct expr_prog_s *prog)
+{
+    free(prog->code);
+    prog->code = NULL;
+    prog->n = 0;
+}
+
+/* Lane loop over the current block */
+#define LANES(stmt)                                                            \
+    for (l = 0; l < len; l++) {                                                \
+        stmt;                                                                  \
+    }                                                                          \
+    break
+
+/*
+ * This function evaluates a compiled program at n points, EXPR_LANES points
+ * at a time.
+ *
+ * Input parameters
+ * - prog: program
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void expr_eval(const struct expr_prog_s *prog, num_t *X, int n, int ld,
+               num_t *result)
+{
+    num_t R[EXPR_MAX_REGS][EXPR_LANES]; /* registers */
+    int idx[EXPR_MAX_LOOPS];            /* loop indices */
+    const struct expr_insn_s *in;
+    num_t *d, *a, *b;
+    num_t *x; /* first point of the block */
+    num_t c;
+    int first, len;
+    int pc, l;
+
+    for (first = 0; first < n; first += EXPR_LANES) {
+        len = MIN(EXPR_LANES, n - first);
+        x = &X[(size_t)first * ld];
+
+        for (pc = 0; pc < prog->n; pc++) {
+            in = &prog->code[pc];
+            d = R[in->dst];
+            a = R[in->a];
+            b = R[in->b];
+            c = in->c;
+
+            switch (in->op) {
+            case EX_CONST: LANES(d[l] = c);
+            case EX_LOADX: LANES(d[l] = x[l * ld + in->a]);
+            case EX_LOADXI: LANES(d[l] = x[l * ld + idx[in->a]]);
+            case EX_INDEX: LANES(d[l] = idx[in->a]);
+            case EX_NEG: LANES(d[l] = -a[l]);
+            case EX_ADD: LANES(d[l] = a[l] + b[l]);
+            case EX_SUB: LANES(d[l] = a[l] - b[l]);
+            case EX_MUL: LANES(d[l] = a[l] * b[l]);
+            case EX_DIV: LANES(d[l] = a[l] / b[l]);
+            case EX_POW: LANES(d[l] = pow(a[l], b[l]));
+            case EX_ADDC: LANES(d[l] = a[l] + c);
+            case EX_RSUBC: LANES(d[l] = c - a[l]);
+            case EX_MULC: LANES(d[l] = a[l] * c);
+            case EX_DIVC: LANES(d[l] = a[l] / c);
+            case EX_RDIVC: LANES(d[l] = c / a[l]);
+            case EX_POWC: LANES(d[l] = pow(a[l], c));
+            case EX_RPOWC: LANES(d[l] = pow(c, a[l]));
+            case EX_SQR: LANES(d[l] = a[l] * a[l]);
+            case EX_SIN: LANES(d[l] = sin(a[l]));
+            case EX_COS: LANES(d[l] = cos(a[l]));
+            case EX_TAN: LANES(d[l] = tan(a[l]));
+            case EX_SQRT: LANES(d[l] = sqrt(a[l]));
+            case EX_EXP: LANES(d[l] = exp(a[l]));
+            case EX_LOG: LANES(d[l] = log(a[l]));
+            case EX_ABS: LANES(d[l] = fabs(a[l]));
+            case EX_LOOP:
+                idx[in->a] = 0;
+                if (prog->nd == 0) {
+                    pc = in->b - 1;
+                }
+                break;
+            case EX_ENDLOOP:
+                if (++idx[in->a] < prog->nd) {
+                    pc = in->b - 1;
+                }
+                break;
+            }
+        }
+
+        memcpy(&result[first], R[0], len * sizeof(num_t));
+    }
+}
+
+/*
+ * This function sets the program evaluated by expr_obj_func() and
+ * expr_obj_func_batch(), which have the objective function signature.
+ *
+ * Input parameters
+ * - prog: program (NULL: none)
+ */
+void expr_set_active(const struct expr_prog_s *prog)
+{
+    active_prog = prog;
+}
+
+/*
+ * Objective function given by the active program
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Return value
+ * Function value at a given point
+ */
+num_t expr_obj_func(num_t *X, int nd)
+{
+    num_t val;
+
+    expr_eval(active_prog, X, 1, nd, &val);
+    return val;
+}
+
+/*
+ * Objective function given by the active program (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void expr_obj_func_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    expr_eval(active_prog, X, n, ld, result);
+}
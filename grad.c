@@ -0,0 +1,277 @@
+/*
+ * Gradient estimators.
+ *
+ * When the objective function has no analytic gradient (or another
+ * estimator is chosen with --grad), the generic solver kernel estimates it
+ * with one of the following (GRAD_*), evaluating the points through the
+ * evaluation cache of the thread:
+ * - central differences: 2 nd evaluations
+ * - forward differences: nd evaluations, plus f(X), which is known after the
+ *   first iteration (best_OF_vals)
+ * - simultaneous perturbation (SPSA): 2 evaluations per draw of a random
+ *   direction (components +1 or -1), whatever nd; the perturbation decays
+ *   as c / (k + 1)^SPSA_GAMMA. The estimate is noisy (its expectation is the
+ *   gradient), so that several draws can be averaged.
+ * The step of each test case is D_INCR, or a fraction of the width of the
+ * [low, high] range (--grad-step).
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "sso.h"
+
+/* Estimator names (GRAD_* order) */
+static const char *const grad_names[] = {"analytic", "central", "forward",
+                                         "spsa"};
+
+/*
+ * This function returns the estimator whose name is given.
+ *
+ * Input parameters
+ * - name: estimator name ("analytic", "central", "forward" or "spsa")
+ *
+ * Return value
+ * It returns GRAD_* or -1 if the name is not valid.
+ */
+int gradient_estimator(const char *name)
+{
+    int est;
+
+    for (est = 0; est < (int)(sizeof(grad_names) / sizeof(grad_names[0]));
+         est++) {
+        if (strcmp(name, grad_names[est]) == 0) {
+            return est;
+        }
+    }
+
+    return -1;
+}
+
+/* Name of estimator est (GRAD_*) */
+const char *gradient_name(int est)
+{
+    return grad_names[est];
+}
+
+/*
+ * This function sets the gradient estimator of a test case. The analytic
+ * gradient is dropped with any other estimator.
+ *
+ * Input parameters
+ * - est: GRAD_* (-1: keep the one of the test case)
+ * - step_rel: step as a fraction of high - low (0: keep the one of the test
+ *   case)
+ * - draws: SPSA draws averaged
+ *
+ * Output parameters
+ * - tc_params: test case parameters
+ *
+ * Return value
+ * It returns -1 if the analytic gradient is chosen but not available.
+ * It returns 1 on success.
+ */
+int gradient_configure(struct tc_params_s *tc_params, int est, num_t step_rel,
+                       int draws)
+{
+    if (est == GRAD_ANALYTIC && tc_params->grad_func == NULL) {
+        return -1;
+    }
+    if (est != -1) {
+        tc_params->grad_est = est;
+        if (est != GRAD_ANALYTIC) {
+            tc_params->grad_func = NULL;
+        }
+    }
+    if (step_rel > 0) {
+        tc_params->grad_step = step_rel * (tc_params->high - tc_params->low);
+    }
+    tc_params->spsa_draws = draws;
+
+    return 1;
+}
+
+/*
+ * This function returns the number of evaluations of a gradient estimate
+ * (forward differences: including f(X)).
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ *
+ * Return value
+ * It returns the number of evaluations.
+ */
+int gradient_evals(const struct tc_params_s *tc_params)
+{
+    switch (tc_params->grad_est) {
+    case GRAD_ANALYTIC:
+        return 0;
+    case GRAD_FORWARD:
+        return tc_params->nd + 1;
+    case GRAD_SPSA:
+        return 2 * tc_params->spsa_draws;
+    default:
+        return 2 * tc_params->nd;
+    }
+}
+
+/*
+ * This function computes the numerical gradient of the objective function of
+ * a test case at a given point using central difference approximation.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - c: evaluation cache (possibly disabled)
+ * - X: input variables (decision variables) vector
+ * - h: step
+ * - ws: gradient workspace (allocated with batch >= 2)
+ *
+ * Output parameters
+ * - c: points stored, counters updated
+ * - result: computed gradient
+ */
+void gradient_central(const struct tc_params_s *tc_params,
+                      struct eval_cache_s *c, num_t *X, double h,
+                      struct grad_ws_s *ws, num_t *result)
+{
+    int nd = tc_params->nd;
+    int i; /* first gradient component of the current chunk */
+    int q; /* component index inside the current chunk */
+    int n; /* number of components in the current chunk */
+
+    gradient_stencil_fill(X, nd, 2 * MIN(ws->batch / 2, nd), ws->stencil);
+
+    for (i = 0; i < nd; i += n) {
+        n = MIN(ws->batch / 2, nd - i);
+        gradient_stencil(X, nd, i, n, h, ws->stencil);
+
+        eval_cached(tc_params, c, ws->stencil, 2 * n, nd, ws->vals);
+        gradient_stencil_restore(X, nd, i, n, ws->stencil);
+
+        for (q = 0; q < n; q++) {
+            result[i + q] = (ws->vals[2 * q] - ws->vals[2 * q + 1]) / (2.0 * h);
+        }
+    }
+}
+
+/*
+ * This function computes the numerical gradient of the objective function of
+ * a test case at a given point using forward difference approximation.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - c: evaluation cache (possibly disabled)
+ * - X: input variables (decision variables) vector
+ * - fx: f(X) (if known)
+ * - fx_known: fx is f(X), else it is evaluated
+ * - h: step
+ * - ws: gradient workspace (allocated with batch >= 2)
+ *
+ * Output parameters
+ * - c: points stored, counters updated (f(X) reused)
+ * - result: computed gradient
+ */
+void gradient_forward(const struct tc_params_s *tc_params,
+                      struct eval_cache_s *c, num_t *X, num_t fx, int fx_known,
+                      double h, struct grad_ws_s *ws, num_t *result)
+{
+    int nd = tc_params->nd;
+    int i; /* first gradient component of the current chunk */
+    int q; /* component index inside the current chunk */
+    int n; /* number of components in the current chunk */
+    num_t *row;
+
+    if (fx_known) {
+        c->reused++;
+    } else {
+        eval_cached(tc_params, c, X, 1, nd, &fx);
+    }
+
+    /* Row q is X + h along component i + q (only that component is set,
+     * then restored) */
+    gradient_stencil_fill(X, nd, MIN(ws->batch, nd), ws->stencil);
+
+    for (i = 0; i < nd; i += n) {
+        n = MIN(ws->batch, nd - i);
+        for (q = 0; q < n; q++) {
+            row = &ws->stencil[(size_t)q * nd];
+            row[i + q] = X[i + q] + h;
+        }
+
+        eval_cached(tc_params, c, ws->stencil, n, nd, ws->vals);
+
+        for (q = 0; q < n; q++) {
+            result[i + q] = (ws->vals[q] - fx) / h;
+            ws->stencil[(size_t)q * nd + i + q] = X[i + q];
+        }
+    }
+}
+
+/*
+ * This function estimates the gradient of the objective function of a test
+ * case at a given point with simultaneous perturbations: for each draw of a
+ * random direction D (components +1 or -1), g_j = (f(X + cD) - f(X - cD)) /
+ * (2 c D_j), averaged over the draws. The directions only depend on the
+ * seed, on the global shark index and on the iteration.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - c: evaluation cache (possibly disabled)
+ * - X: input variables (decision variables) vector
+ * - h: perturbation
+ * - seed: PRNG seed
+ * - shark: global shark index
+ * - k: iteration
+ * - ws: gradient workspace (allocated with batch >= 2)
+ *
+ * Output parameters
+ * - c: points stored, counters updated
+ * - result: estimated gradient
+ */
+void gradient_spsa(const struct tc_params_s *tc_params,
+                   struct eval_cache_s *c, num_t *X, double h, uint64_t seed,
+                   int shark, int k, struct grad_ws_s *ws, num_t *result)
+{
+    int nd = tc_params->nd;
+    int draws = tc_params->spsa_draws;
+    num_t *D = ws->point; /* direction */
+    int d;                /* first draw of the current chunk */
+    int q;                /* draw index inside the current chunk */
+    int n;                /* number of draws in the current chunk */
+    int j;
+    num_t *plus, *minus;
+    double diff;
+
+    memset(result, 0, nd * sizeof(num_t));
+
+    for (d = 0; d < draws; d += n) {
+        n = MIN(ws->batch / 2, draws - d);
+
+        /* Rows 2q and 2q+1 are X + cD and X - cD for draw d + q */
+        for (q = 0; q < n; q++) {
+            rng_fill_uniform(seed, RNG_STREAM_SPSA, (uint32_t)shark,
+                             (uint32_t)k, (uint32_t)(d + q) * nd, nd, D);
+            plus = &ws->stencil[(size_t)(2 * q) * nd];
+            minus = plus + nd;
+            for (j = 0; j < nd; j++) {
+                D[j] = D[j] < 0.5 ? -1 : 1;
+                plus[j] = X[j] + h * D[j];
+                minus[j] = X[j] - h * D[j];
+            }
+        }
+
+        eval_cached(tc_params, c, ws->stencil, 2 * n, nd, ws->vals);
+
+        /* Regenerate the directions (D_j = 1 / D_j) */
+        for (q = 0; q < n; q++) {
+            rng_fill_uniform(seed, RNG_STREAM_SPSA, (uint32_t)shark,
+                             (uint32_t)k, (uint32_t)(d + q) * nd, nd, D);
+            diff = (ws->vals[2 * q] - ws->vals[2 * q + 1]) / (2 * h * draws);
+            for (j = 0; j < nd; j++) {
+                result[j] += D[j] < 0.5 ? -diff : diff;
+            }
+        }
+    }
+}
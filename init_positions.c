@@ -4,32 +4,36 @@
  * (C) 2021 Giuseppe Vitolo
  */
 
-#include <stdlib.h>
-
 #include "sso.h"
 
 /*
  * This function initializes the NP solution vectors with values randomly
- * sampled from a [low, high] interval.
+ * sampled from a [low, high] interval. The values of each shark only depend on
+ * the seed and on the global shark index (pop->offset + i).
  *
  * Input parameters
- * - np: population size
- * - nd: number of decision variables
+ * - pop: population (np, nd, offset and seed must be set)
  * - low: lowest sampled value
  * - high: highest sampled value
  *
  * Output parameters
- * - X: initial solution matrix (dimensions: np * nd)
+ * - pop: population with initial solution vectors in pop->X (no completed
+ *   iterations)
  */
-void init_positions(num_t **X, int np, int nd, num_t low, num_t high)
+void init_positions(struct population_s *pop, num_t low, num_t high)
 {
     int i, j;
 
-    for (i = 0; i < np; i++) {
-        for (j = 0; j < nd; j++) {
-            X[i][j] = (num_t)rand() / RAND_MAX; /* [0,1] */
-            X[i][j] = (high - low) * X[i][j];   /* [0, high - low] */
-            X[i][j] = X[i][j] + low;            /* [low, high] */
+    pop->iter = 0;
+    for (i = 0; i < pop->np; i++) {
+        /* [0,1) */
+        rng_fill_uniform(pop->seed, RNG_STREAM_INIT,
+                         (uint32_t)(pop->offset + i), 0, 0, pop->nd,
+                         pop->X[i]);
+
+        for (j = 0; j < pop->nd; j++) {
+            pop->X[i][j] = (high - low) * pop->X[i][j]; /* [0, high - low) */
+            pop->X[i][j] = pop->X[i][j] + low;          /* [low, high) */
         }
     }
 }
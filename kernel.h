@@ -0,0 +1,120 @@
+/*
+ * Solver kernel template: one step of the SSO algorithm for one shark
+ * (gradient, velocity and forward movement, rotational movement, evaluation
+ * and selection of the best candidate position).
+ *
+ * This file is included by kernels.c once per kernel, with the following
+ * macros defined:
+ * - KERNEL_NAME: name of the (static) function, a shark_step_t
+ * - KERNEL_ND: number of decision variables (a constant, so that the loops
+ *   over the decision variables are fully unrolled, or tc_params->nd)
+ * - KERNEL_GRAD(X, result): gradient of the objective function at X
+ * - KERNEL_EVAL(X, n, ld, result): objective function at n points, one every
+ *   ld elements from X (the kernel workspace ws may be used)
+ * They are undefined at the end of the file.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+/*
+ * This function moves shark i to its best candidate position. The random
+ * numbers used only depend on pop->seed, on the global shark index
+ * pop->offset + i and on the iteration k.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - pop: population
+ * - i: local shark index
+ * - k: iteration
+ * - R1, R2: random numbers of the iteration, in [0,1)
+ * - ws: workspace of the calling thread
+ *
+ * Output parameters
+ * - pop: X[i], V[i] and best_OF_vals[i] updated
+ * - ws: candidates of shark i, profile updated (SSO_PROFILE builds)
+ */
+static void KERNEL_NAME(const struct tc_params_s *tc_params,
+                        struct population_s *pop, int i, int k, num_t R1,
+                        num_t R2, struct shark_ws_s *ws)
+{
+    num_t *X = pop->X[i];             /* position */
+    num_t *V = pop->V[i];             /* velocity */
+    num_t *Y = ws->cand;              /* next forward position */
+    num_t *Z = ws->cand + pop->ld;    /* next rotational positions */
+    int ld = pop->ld;                 /* candidate row stride */
+    num_t *gradient_result = ws->gradient_result;
+    num_t *cand_OF_vals = ws->cand_OF_vals;
+    num_t *R3 = ws->R3;
+    int m_points = tc_params->m_points;
+    int j, m;
+    num_t velocities[2]; /* velocity (0) and velocity limit (1) */
+    int vel_limit_idx;   /* velocity limit index (0 or 1) */
+
+    /* Compute gradient */
+    KERNEL_GRAD(X, gradient_result);
+    PROF_LAP(ws->prof, PROF_GRADIENT, ws->prof_t, gradient_evals(tc_params));
+
+    /* Compute velocities and forward movement */
+    for (j = 0; j < KERNEL_ND; j++) {
+        /* Compute new velocity */
+        velocities[0] = tc_params->eta * R1 * gradient_result[j] +
+                        tc_params->alpha * R2 * V[j];
+
+        /* Compute velocity limit */
+        velocities[1] = tc_params->beta * V[j];
+
+        /* Choose the velocity with the smallest abs value */
+        vel_limit_idx = min_abs(velocities[0], velocities[1]);
+        V[j] = velocities[vel_limit_idx];
+
+        /* Set forward movement */
+        Y[j] = X[j] + V[j] * tc_params->delta_t;
+    }
+    PROF_LAP(ws->prof, PROF_UPDATE, ws->prof_t, 0);
+
+    /* Set rotational movement positions (local search) */
+    rng_fill_uniform(pop->seed, RNG_STREAM_R3, (uint32_t)(pop->offset + i), k,
+                     0, m_points, R3); /* [0,1) */
+
+    for (m = 0; m < m_points; m++) {
+        R3[m] = 2 * R3[m]; /* [0,2) */
+        R3[m] = R3[m] - 1; /* [-1,1) */
+
+        for (j = 0; j < KERNEL_ND; j++) {
+            Z[(size_t)m * ld + j] = Y[j] + R3[m] * Y[j];
+        }
+    }
+    PROF_LAP(ws->prof, PROF_ROTATE, ws->prof_t, 0);
+
+    /* Evaluate forward and rotational positions in a single call (the
+     * rotational positions follow Y with stride ld). After the first
+     * iteration best_OF_vals[i] is f(X): it is reused when the forward
+     * position equals X (vanishing velocity, or lost in the rounding of
+     * X + V) */
+    if (k > 0 && memcmp(Y, X, KERNEL_ND * sizeof(num_t)) == 0) {
+        cand_OF_vals[0] = pop->best_OF_vals[i];
+        KERNEL_EVAL(Z, m_points, ld, &cand_OF_vals[1]);
+        ws->cache.reused++;
+    } else {
+        KERNEL_EVAL(Y, 1 + m_points, ld, cand_OF_vals);
+    }
+    PROF_LAP(ws->prof, PROF_EVAL, ws->prof_t, 1 + m_points);
+
+    /* Choose the best position among forward and rotational positions */
+    memcpy(X, Y, KERNEL_ND * sizeof(num_t));
+    pop->best_OF_vals[i] = cand_OF_vals[0];
+
+    for (m = 0; m < m_points; m++) {
+        /* Compare current OF value with the best OF value stored */
+        if (cand_OF_vals[1 + m] > pop->best_OF_vals[i]) {
+            memcpy(X, &Z[(size_t)m * ld], KERNEL_ND * sizeof(num_t));
+            pop->best_OF_vals[i] = cand_OF_vals[1 + m];
+        }
+    }
+    PROF_LAP(ws->prof, PROF_SELECT, ws->prof_t, 0);
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_ND
+#undef KERNEL_GRAD
+#undef KERNEL_EVAL
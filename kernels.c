@@ -0,0 +1,176 @@
+/*
+ * Solver kernels.
+ *
+ * kernel.h is instantiated once for any test case (generic kernel: nd and
+ * objective function from the test case parameters) and, for the test cases
+ * with two and five decision variables, with a constant nd and direct calls
+ * to the objective function and its gradient, so that the loops over the
+ * decision variables are fully unrolled and the calls can be inlined.
+ * select_kernel() picks the kernel matching the test case parameters, falling
+ * back to the generic one.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "sso.h"
+
+/*
+ * This function computes the gradient of the objective function of a test
+ * case at the position of a shark with its estimator (GRAD_*): the analytic
+ * gradient, or finite differences / simultaneous perturbations evaluated
+ * through the evaluation cache (batched if possible).
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - pop: population (f(X) is known after the first iteration)
+ * - i: shark index
+ * - k: iteration
+ * - ws: kernel workspace
+ *
+ * Output parameters
+ * - result: gradient
+ */
+static void compute_gradient(const struct tc_params_s *tc_params,
+                             struct population_s *pop, int i, int k,
+                             struct shark_ws_s *ws, num_t *result)
+{
+    num_t *X = pop->X[i];
+
+    switch (tc_params->grad_est) {
+    case GRAD_ANALYTIC:
+        tc_params->grad_func(X, tc_params->nd, result);
+        break;
+    case GRAD_FORWARD:
+        gradient_forward(tc_params, &ws->cache, X, pop->best_OF_vals[i], k > 0,
+                         tc_params->grad_step, &ws->grad, result);
+        break;
+    case GRAD_SPSA:
+        gradient_spsa(tc_params, &ws->cache, X,
+                      tc_params->grad_step / pow(k + 1, SPSA_GAMMA), pop->seed,
+                      pop->offset + i, k, &ws->grad, result);
+        break;
+    default:
+        gradient_central(tc_params, &ws->cache, X, tc_params->grad_step,
+                         &ws->grad, result);
+    }
+}
+
+/* Generic kernel (any test case, plugin or expression; the only one using
+ * the evaluation cache) */
+#define KERNEL_NAME shark_step_generic
+#define KERNEL_ND tc_params->nd
+#define KERNEL_GRAD(X, result)                                                 \
+    compute_gradient(tc_params, pop, i, k, ws, result)
+#define KERNEL_EVAL(X, n, ld, result)                                          \
+    eval_cached(tc_params, &ws->cache, X, n, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_elliptic_paraboloid_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) elliptic_paraboloid_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result)                                          \
+    elliptic_paraboloid_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_goldstein_price_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) goldstein_price_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result) goldstein_price_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_flipped_goldstein_price_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) flipped_goldstein_price_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result)                                          \
+    flipped_goldstein_price_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_rastrigin_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) rastrigin_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result) rastrigin_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_rastrigin_5
+#define KERNEL_ND 5
+#define KERNEL_GRAD(X, result) rastrigin_grad(X, 5, result)
+#define KERNEL_EVAL(X, n, ld, result) rastrigin_batch(X, n, 5, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_griewangk_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) griewangk_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result) griewangk_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_griewangk_5
+#define KERNEL_ND 5
+#define KERNEL_GRAD(X, result) griewangk_grad(X, 5, result)
+#define KERNEL_EVAL(X, n, ld, result) griewangk_batch(X, n, 5, ld, result)
+#include "kernel.h"
+
+#define KERNEL_NAME shark_step_schaffer_2
+#define KERNEL_ND 2
+#define KERNEL_GRAD(X, result) schaffer_grad(X, 2, result)
+#define KERNEL_EVAL(X, n, ld, result) schaffer_batch(X, n, 2, ld, result)
+#include "kernel.h"
+
+/* Specialized kernels, identified by nd, batched objective function and
+ * gradient */
+#define KERNEL_ENTRY(NAME, ND)                                                 \
+    {ND, NAME##_batch, NAME##_grad, shark_step_##NAME##_##ND, #NAME "/" #ND}
+
+static const struct {
+    int nd;
+    void (*obj_func_batch)(num_t *, int, int, int, num_t *);
+    void (*grad_func)(num_t *, int, num_t *);
+    shark_step_t step;
+    const char *name;
+} kernels[] = {KERNEL_ENTRY(elliptic_paraboloid, 2),
+               KERNEL_ENTRY(goldstein_price, 2),
+               KERNEL_ENTRY(flipped_goldstein_price, 2),
+               KERNEL_ENTRY(rastrigin, 2),
+               KERNEL_ENTRY(rastrigin, 5),
+               KERNEL_ENTRY(griewangk, 2),
+               KERNEL_ENTRY(griewangk, 5),
+               KERNEL_ENTRY(schaffer, 2)};
+
+/*
+ * This function selects the solver kernel of a test case: a specialized one
+ * if the test case uses one of the objective functions above with the same
+ * nd and its analytic gradient, otherwise the generic one.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - generic: always select the generic kernel
+ *
+ * Output parameters
+ * - name: kernel name ("generic" or "FUNCTION/ND", ignored if NULL)
+ *
+ * Return value
+ * It returns the kernel.
+ */
+shark_step_t select_kernel(const struct tc_params_s *tc_params, int generic,
+                           const char **name)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(kernels) / sizeof(kernels[0]) && !generic; i++) {
+        if (kernels[i].nd == tc_params->nd &&
+            kernels[i].obj_func_batch == tc_params->obj_func_batch &&
+            kernels[i].grad_func == tc_params->grad_func) {
+            if (name != NULL) {
+                *name = kernels[i].name;
+            }
+            return kernels[i].step;
+        }
+    }
+
+    if (name != NULL) {
+        *name = "generic";
+    }
+    return shark_step_generic;
+}
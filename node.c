@@ -0,0 +1,250 @@
+/*
+ * Node-level shared memory (--shared).
+ *
+ * The processes running on the same node (MPI_COMM_TYPE_SHARED) allocate
+ * their populations in a single MPI-3 shared memory window, whose first
+ * segment (node leader, node rank 0) also holds one best solution vector and
+ * one set of final statistics per process of the node, plus the result of the
+ * last global best exchange. Every process stores its results there and the
+ * leader combines them by reading the segment directly, so that only the node
+ * leaders take part in the exchanges (see exchange.c) and in the reductions
+ * among the nodes. Row pointers inside a population arena are only valid in
+ * the process owning it (the window may be mapped at different addresses).
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/* Round p up to a multiple of CACHE_LINE */
+static char *align_line(char *p)
+{
+    return (char *)(((uintptr_t)p + CACHE_LINE - 1) &
+                    ~(uintptr_t)(CACHE_LINE - 1));
+}
+
+/*
+ * This function combines two sets of final statistics (minimum, maximum or
+ * sum of each field, see struct node_stats_s).
+ *
+ * Input parameters
+ * - in: final statistics
+ * - inout: final statistics
+ *
+ * Output parameters
+ * - inout: combined final statistics
+ */
+static void combine_stats(const struct node_stats_s *in,
+                          struct node_stats_s *inout)
+{
+    inout->time_min = MIN(inout->time_min, in->time_min);
+    inout->time_max = MAX(inout->time_max, in->time_max);
+    inout->time_sum += in->time_sum;
+    inout->exchange_wait = MAX(inout->exchange_wait, in->exchange_wait);
+    inout->evals += in->evals;
+    inout->lookups += in->lookups;
+    inout->cache_hits += in->cache_hits;
+    inout->reused += in->reused;
+    inout->rss_max = MAX(inout->rss_max, in->rss_max);
+    inout->rss_sum += in->rss_sum;
+    inout->target_iter = MIN(inout->target_iter, in->target_iter);
+    inout->iterations = MAX(inout->iterations, in->iterations);
+    inout->stop_reason = MAX(inout->stop_reason, in->stop_reason);
+}
+
+/*
+ * MPI reduce operation on final statistics (see node_stats_reduce()).
+ */
+static void reduce_stats(void *in_param, void *inout_param, int *len,
+                         MPI_Datatype *dt)
+{
+    struct node_stats_s *in = (struct node_stats_s *)in_param;
+    struct node_stats_s *inout = (struct node_stats_s *)inout_param;
+    int i;
+
+    (void)dt;
+    for (i = 0; i < *len; i++) {
+        combine_stats(&in[i], &inout[i]);
+    }
+}
+
+/*
+ * This function creates the node communicators and allocates the shared
+ * window: results of every process of the node and exchange result (leader
+ * segment) and the population arena of each process.
+ *
+ * Input parameters
+ * - comm: communicator
+ * - nd: number of decision variables
+ * - pop_size: population arena size (bytes, see population_size(); 0: no
+ *   population)
+ *
+ * Output parameters
+ * - node: node communicators and shared window
+ * - pop_arena: population arena (CACHE_LINE aligned, NULL if pop_size is 0)
+ *
+ * Return value
+ * It returns -1 if the shared window could not be allocated.
+ * It returns 1 on success.
+ */
+int node_init(struct node_s *node, MPI_Comm comm, int nd, size_t pop_size,
+              void **pop_arena)
+{
+    MPI_Info info;
+    MPI_Aint seg_size; /* size of the leader segment */
+    size_t hdr_size;   /* results (leader segment) */
+    int disp_unit;
+    char *base;        /* segment of this process */
+    char *leader;      /* segment of the node leader */
+    int rank;
+    int status;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+                        &node->comm);
+    MPI_Comm_rank(node->comm, &node->rank);
+    MPI_Comm_size(node->comm, &node->size);
+
+    /* The leader of the first node is process 0 of comm, and process 0 of
+     * the leaders communicator */
+    MPI_Comm_split(comm, node->rank == 0 ? 0 : MPI_UNDEFINED, rank,
+                   &node->leaders);
+    node->nd = nd;
+
+    hdr_size = (size_t)node->size * sizeof(struct node_stats_s) +
+               CACHE_LINE +
+               (size_t)(node->size + 1) * (nd + 1) * sizeof(num_t);
+
+    /* Every segment gets a cache line of slack for the alignment */
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    status = MPI_Win_allocate_shared(
+        (MPI_Aint)((node->rank == 0 ? hdr_size + CACHE_LINE : 0) +
+                   (pop_size > 0 ? pop_size + CACHE_LINE : 0)),
+        1, info, node->comm, &base, &node->win);
+    MPI_Info_free(&info);
+    if (status != MPI_SUCCESS) {
+        return -1;
+    }
+
+    MPI_Win_shared_query(node->win, 0, &seg_size, &disp_unit, &leader);
+    node->stats = (struct node_stats_s *)align_line(leader);
+    node->best = (num_t *)align_line((char *)(node->stats + node->size));
+    node->result = node->best + (size_t)node->size * (nd + 1);
+
+    if (node->rank == 0) {
+        base = (char *)(node->result + nd + 1);
+    }
+    *pop_arena = pop_size > 0 ? align_line(base) : NULL;
+
+    /* Stores are made visible with MPI_Win_sync() (passive target epoch
+     * open until node_free()) */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, node->win);
+
+    return 1;
+}
+
+/*
+ * This function combines the results of the processes of a node at the node
+ * leader: the best solution vector (last element: objective function value)
+ * and the final statistics. It must be called by every process of the node
+ * (the results of a call must be read before the next one starts).
+ *
+ * Input parameters
+ * - node: node communicators and shared window
+ * - goal: MIN_GOAL / MAX_GOAL (objective function values in best as
+ *   reported, not maximized)
+ * - best: best solution vector of this process (length: nd+1)
+ * - stats: final statistics of this process
+ *
+ * Output parameters (node leader only)
+ * - best: best solution vector of the node (ties: lowest rank)
+ * - stats: final statistics of the node
+ */
+void node_reduce(struct node_s *node, int goal, num_t *best,
+                 struct node_stats_s *stats)
+{
+    int nd = node->nd;
+    num_t *row;
+    int i;
+
+    memcpy(&node->best[(size_t)node->rank * (nd + 1)], best,
+           (nd + 1) * sizeof(num_t));
+    node->stats[node->rank] = *stats;
+
+    MPI_Win_sync(node->win);
+    MPI_Barrier(node->comm);
+    MPI_Win_sync(node->win);
+
+    if (node->rank != 0) {
+        return;
+    }
+
+    for (i = 1; i < node->size; i++) {
+        row = &node->best[(size_t)i * (nd + 1)];
+        if (goal == MIN_GOAL ? row[nd] < best[nd] : row[nd] > best[nd]) {
+            memcpy(best, row, (nd + 1) * sizeof(num_t));
+        }
+
+        combine_stats(&node->stats[i], stats);
+    }
+}
+
+/*
+ * This function reduces the final statistics of the processes of comm at
+ * process 0 with a single MPI_Reduce (one struct datatype, user-defined
+ * operation combining the fields as node_reduce()).
+ *
+ * Input parameters
+ * - stats: final statistics of this process
+ * - comm: communicator
+ *
+ * Output parameters (process 0 of comm only)
+ * - result: final statistics of the processes of comm
+ */
+void node_stats_reduce(const struct node_stats_s *stats,
+                       struct node_stats_s *result, MPI_Comm comm)
+{
+    int lens[4] = {4, 4, 2, 3};
+    MPI_Aint displs[4] = {offsetof(struct node_stats_s, time_min),
+                          offsetof(struct node_stats_s, evals),
+                          offsetof(struct node_stats_s, rss_max),
+                          offsetof(struct node_stats_s, target_iter)};
+    MPI_Datatype types[4] = {MPI_DOUBLE, MPI_LONG_LONG, MPI_LONG, MPI_INT};
+    MPI_Datatype fields_type, stats_type;
+    MPI_Op op;
+
+    MPI_Type_create_struct(4, lens, displs, types, &fields_type);
+    MPI_Type_create_resized(fields_type, 0, sizeof(struct node_stats_s),
+                            &stats_type);
+    MPI_Type_commit(&stats_type);
+    MPI_Op_create((MPI_User_function *)&reduce_stats, 1, &op);
+
+    MPI_Reduce(stats, result, 1, stats_type, op, 0, comm);
+
+    MPI_Op_free(&op);
+    MPI_Type_free(&stats_type);
+    MPI_Type_free(&fields_type);
+}
+
+/*
+ * This function frees the shared window and the node communicators (the
+ * population arenas inside the window must not be used afterwards).
+ *
+ * Input parameters
+ * - node: node communicators and shared window
+ */
+void node_free(struct node_s *node)
+{
+    MPI_Win_unlock_all(node->win);
+    MPI_Win_free(&node->win);
+    if (node->leaders != MPI_COMM_NULL) {
+        MPI_Comm_free(&node->leaders);
+    }
+    MPI_Comm_free(&node->comm);
+}
@@ -4,10 +4,13 @@
  * (C) 2021 Giuseppe Vitolo
  */
 
-#include <math.h>
+#include <tgmath.h>
 
 #include "sso.h"
 
+/* pi in the arithmetic precision of the objective functions */
+#define PI ((acc_t)M_PI)
+
 /*
  * Elliptic paraboloid function
  * Goal: minimization
@@ -21,7 +24,57 @@
  */
 num_t elliptic_paraboloid(num_t *X, int nd)
 {
-    return -1.0*(X[0] * X[0] - 4 * X[0] * X[1] + 5 * X[1] * X[1] - 4 * X[1] + 3);
+    acc_t x, y;
+
+    x = X[0];
+    y = X[1];
+
+    return -(x * x - 4 * x * y + 5 * y * y - 4 * y + 3);
+}
+
+/*
+ * Elliptic paraboloid function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void elliptic_paraboloid_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    int p;
+    acc_t x, y;
+
+    for (p = 0; p < n; p++) {
+        x = X[p * ld];
+        y = X[p * ld + 1];
+        result[p] = -(x * x - 4 * x * y + 5 * y * y - 4 * y + 3);
+    }
+}
+
+/*
+ * Elliptic paraboloid function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void elliptic_paraboloid_grad(num_t *X, int nd, num_t *result)
+{
+    acc_t x, y;
+
+    x = X[0];
+    y = X[1];
+
+    result[0] = -(2 * x - 4 * y);
+    result[1] = -(-4 * x + 10 * y - 4);
 }
 
 /*
@@ -37,17 +90,88 @@ num_t elliptic_paraboloid(num_t *X, int nd)
  */
 num_t goldstein_price(num_t *X, int nd)
 {
-    num_t a;
-    num_t b;
+    acc_t x, y;
+    acc_t a;
+    acc_t b;
 
-    a = (1 + ((X[0] + X[1] + 1) * (X[0] + X[1] + 1)) *
-                 (19 - 14 * X[0] + 3 * X[0] * X[0] - 14 * X[1] +
-                  6 * X[0] * X[1] + 3 * X[1] * X[1]));
-    b = (30 + ((2 * X[0] - 3 * X[1]) * (2 * X[0] - 3 * X[1])) *
-                  (18 - 32 * X[0] + 12 * X[0] * X[0] + 48 * X[1] -
-                   36 * X[0] * X[1] + 27 * X[1] * X[1]));
+    x = X[0];
+    y = X[1];
+    a = (1 + ((x + y + 1) * (x + y + 1)) *
+                 (19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y));
+    b = (30 + ((2 * x - 3 * y) * (2 * x - 3 * y)) *
+                  (18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y +
+                   27 * y * y));
 
-    return -1.0*(a * b);
+    return -(a * b);
+}
+
+/*
+ * Goldstein-Price function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void goldstein_price_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    int p;
+    acc_t x, y;
+    acc_t a;
+    acc_t b;
+
+    for (p = 0; p < n; p++) {
+        x = X[p * ld];
+        y = X[p * ld + 1];
+        a = (1 + ((x + y + 1) * (x + y + 1)) *
+                     (19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y));
+        b = (30 + ((2 * x - 3 * y) * (2 * x - 3 * y)) *
+                      (18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y +
+                       27 * y * y));
+        result[p] = -(a * b);
+    }
+}
+
+/*
+ * Goldstein-Price function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void goldstein_price_grad(num_t *X, int nd, num_t *result)
+{
+    acc_t x, y;
+    acc_t s, t;   /* x + y + 1, 2x - 3y */
+    acc_t A, B;   /* second factors of a and b */
+    acc_t a, b;
+    acc_t da_dx, da_dy;
+    acc_t db_dx, db_dy;
+
+    x = X[0];
+    y = X[1];
+    s = x + y + 1;
+    t = 2 * x - 3 * y;
+    A = 19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y;
+    B = 18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y + 27 * y * y;
+    a = 1 + s * s * A;
+    b = 30 + t * t * B;
+
+    /* dA/dx = dA/dy */
+    da_dx = 2 * s * A + s * s * (-14 + 6 * x + 6 * y);
+    da_dy = da_dx;
+    db_dx = 4 * t * B + t * t * (-32 + 24 * x - 36 * y);
+    db_dy = -6 * t * B + t * t * (48 - 36 * x + 54 * y);
+
+    result[0] = -(da_dx * b + a * db_dx);
+    result[1] = -(da_dy * b + a * db_dy);
 }
 
 /*
@@ -63,17 +187,89 @@ num_t goldstein_price(num_t *X, int nd)
  */
 num_t flipped_goldstein_price(num_t *X, int nd)
 {
-    num_t a;
-    num_t b;
+    acc_t x, y;
+    acc_t a;
+    acc_t b;
+
+    x = X[0];
+    y = X[1];
+    a = (1 + ((x + y + 1) * (x + y + 1)) *
+                 (19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y));
+    b = (30 + ((2 * x - 3 * y) * (2 * x - 3 * y)) *
+                  (18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y +
+                   27 * y * y));
+
+    return -(a * b);
+}
+
+/*
+ * "Flipped" Goldstein-Price function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void flipped_goldstein_price_batch(num_t *X, int n, int nd, int ld,
+                                   num_t *result)
+{
+    int p;
+    acc_t x, y;
+    acc_t a;
+    acc_t b;
 
-    a = (1 + ((X[0] + X[1] + 1) * (X[0] + X[1] + 1)) *
-                 (19 - 14 * X[0] + 3 * X[0] * X[0] - 14 * X[1] +
-                  6 * X[0] * X[1] + 3 * X[1] * X[1]));
-    b = (30 + ((2 * X[0] - 3 * X[1]) * (2 * X[0] - 3 * X[1])) *
-                  (18 - 32 * X[0] + 12 * X[0] * X[0] + 48 * X[1] -
-                   36 * X[0] * X[1] + 27 * X[1] * X[1]));
+    for (p = 0; p < n; p++) {
+        x = X[p * ld];
+        y = X[p * ld + 1];
+        a = (1 + ((x + y + 1) * (x + y + 1)) *
+                     (19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y));
+        b = (30 + ((2 * x - 3 * y) * (2 * x - 3 * y)) *
+                      (18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y +
+                       27 * y * y));
+        result[p] = -(a * b);
+    }
+}
 
-    return -1.0*(a * b);
+/*
+ * "Flipped" Goldstein-Price function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void flipped_goldstein_price_grad(num_t *X, int nd, num_t *result)
+{
+    acc_t x, y;
+    acc_t s, t;   /* x + y + 1, 2x - 3y */
+    acc_t A, B;   /* second factors of a and b */
+    acc_t a, b;
+    acc_t da_dx, da_dy;
+    acc_t db_dx, db_dy;
+
+    x = X[0];
+    y = X[1];
+    s = x + y + 1;
+    t = 2 * x - 3 * y;
+    A = 19 - 14 * x + 3 * x * x - 14 * y + 6 * x * y + 3 * y * y;
+    B = 18 - 32 * x + 12 * x * x + 48 * y - 36 * x * y + 27 * y * y;
+    a = 1 + s * s * A;
+    b = 30 + t * t * B;
+
+    /* dA/dx = dA/dy */
+    da_dx = 2 * s * A + s * s * (-14 + 6 * x + 6 * y);
+    da_dy = da_dx;
+    db_dx = 4 * t * B + t * t * (-32 + 24 * x - 36 * y);
+    db_dy = -6 * t * B + t * t * (48 - 36 * x + 54 * y);
+
+    result[0] = -(da_dx * b + a * db_dx);
+    result[1] = -(da_dy * b + a * db_dy);
 }
 
 /*
@@ -90,13 +286,65 @@ num_t flipped_goldstein_price(num_t *X, int nd)
 num_t rastrigin(num_t *X, int nd)
 {
     int i;
-    num_t val = 0;
+    acc_t x;
+    acc_t val = 0;
 
     for (i = 0; i < nd; i++) {
-        val += X[i] * X[i] - 10 * cos(2 * M_PI * X[i]);
+        x = X[i];
+        val += x * x - 10 * cos(2 * PI * x);
     }
 
-    return -1.0*(10 * nd + val);
+    return -(10 * nd + val);
+}
+
+/*
+ * Rastrigin function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void rastrigin_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    int i, p;
+    acc_t x;
+    acc_t val; /* sum in acc_t precision, not in result[p] */
+
+    for (p = 0; p < n; p++) {
+        val = 0;
+        for (i = 0; i < nd; i++) {
+            x = X[p * ld + i];
+            val += x * x - 10 * cos(2 * PI * x);
+        }
+
+        result[p] = -(10 * nd + val);
+    }
+}
+
+/*
+ * Rastrigin function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void rastrigin_grad(num_t *X, int nd, num_t *result)
+{
+    int i;
+    acc_t x;
+
+    for (i = 0; i < nd; i++) {
+        x = X[i];
+        result[i] = -(2 * x + 20 * PI * sin(2 * PI * x));
+    }
 }
 
 /*
@@ -113,18 +361,90 @@ num_t rastrigin(num_t *X, int nd)
 num_t griewangk(num_t *X, int nd)
 {
     int i;
-    num_t a = 0.0;
-    num_t b = 1.0;
+    acc_t x;
+    acc_t a = 0.0;
+    acc_t b = 1.0;
 
     for (i = 0; i < nd; i++) {
-        a += (X[i] * X[i]) / (num_t)4000;
+        x = X[i];
+        a += (x * x) / (acc_t)4000;
+    }
+
+    for (i = 0; i < nd; i++) {
+        b *= cos(X[i] / sqrt((acc_t)i + 1));
+    }
+
+    return -(a - b + 1);
+}
+
+/*
+ * Griewangk function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void griewangk_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    int i, p;
+    acc_t x;
+    acc_t a;
+    acc_t b;
+
+    for (p = 0; p < n; p++) {
+        a = 0.0;
+        b = 1.0;
+
+        for (i = 0; i < nd; i++) {
+            x = X[p * ld + i];
+            a += (x * x) / (acc_t)4000;
+        }
+
+        for (i = 0; i < nd; i++) {
+            b *= cos(X[p * ld + i] / sqrt((acc_t)i + 1));
+        }
+
+        result[p] = -(a - b + 1);
     }
+}
 
+/*
+ * Griewangk function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void griewangk_grad(num_t *X, int nd, num_t *result)
+{
+    int i;
+    acc_t x;
+    acc_t prod = 1.0; /* running product of the cosine terms */
+
+    /* Store in result[i] the product of the cosine terms before i, then
+     * multiply it by the product of the terms after i (no division, so a zero
+     * cosine term is handled correctly) */
     for (i = 0; i < nd; i++) {
-        b *= cos(X[i] / sqrt((double)i + 1));
+        result[i] = prod;
+        prod *= cos(X[i] / sqrt((acc_t)i + 1));
     }
 
-    return -1.0*(a - b + 1);
+    prod = 1.0;
+    for (i = nd - 1; i >= 0; i--) {
+        x = X[i];
+        result[i] = -(x / (acc_t)2000 + result[i] * prod *
+                                            sin(x / sqrt((acc_t)i + 1)) /
+                                            sqrt((acc_t)i + 1));
+        prod *= cos(x / sqrt((acc_t)i + 1));
+    }
 }
 
 /*
@@ -140,14 +460,271 @@ num_t griewangk(num_t *X, int nd)
  */
 num_t schaffer(num_t *X, int nd)
 {
-    num_t a;
-    num_t b;
+    acc_t x, y;
+    acc_t a;
+    acc_t b;
+
+    x = X[0];
+    y = X[1];
+    a = sin(sqrt(x * x + y * y)) * sin(sqrt(x * x + y * y)) - (acc_t)0.5;
+    b = (1 + (acc_t)0.001 * (x * x + y * y)) *
+        (1 + (acc_t)0.001 * (x * x + y * y));
+
+    return -((acc_t)0.5 + a / b);
+}
+
+/*
+ * Schaffer function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void schaffer_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    int p;
+    acc_t x, y;
+    acc_t r2; /* x^2 + y^2 */
+    acc_t a;
+    acc_t b;
+
+    for (p = 0; p < n; p++) {
+        x = X[p * ld];
+        y = X[p * ld + 1];
+        r2 = x * x + y * y;
+        a = sin(sqrt(r2)) * sin(sqrt(r2)) - (acc_t)0.5;
+        b = (1 + (acc_t)0.001 * r2) * (1 + (acc_t)0.001 * r2);
+        result[p] = -((acc_t)0.5 + a / b);
+    }
+}
+
+/*
+ * Schaffer function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd)
+ */
+void schaffer_grad(num_t *X, int nd, num_t *result)
+{
+    acc_t x, y;
+    acc_t r2; /* x^2 + y^2 */
+    acc_t r;  /* sqrt(r2) */
+    acc_t a, b;
+    acc_t da; /* da/d(r2) */
+    acc_t db; /* db/d(r2) */
+    acc_t d;  /* d(a/b)/d(r2) */
+
+    x = X[0];
+    y = X[1];
+    r2 = x * x + y * y;
+    r = sqrt(r2);
+    a = sin(r) * sin(r) - (acc_t)0.5;
+    b = (1 + (acc_t)0.001 * r2) * (1 + (acc_t)0.001 * r2);
+
+    /* d(sin^2(r))/d(r2) = sin(r)cos(r)/r, which tends to 1 as r -> 0 */
+    da = (r > 0) ? sin(r) * cos(r) / r : 1;
+    db = (acc_t)0.002 * (1 + (acc_t)0.001 * r2);
+    d = (da * b - a * db) / (b * b);
+
+    result[0] = -d * 2 * x;
+    result[1] = -d * 2 * y;
+}
+
+/*
+ * Rastrigin function with a variable evaluation cost. It emulates objective
+ * functions whose cost depends on the input point: the function value is the
+ * same as rastrigin(), but each evaluation also performs between VC_WORK and
+ * 10 * VC_WORK dummy operations, depending on the first decision variable.
+ * Goal: minimization
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Return value
+ * Function value at a given point
+ */
+num_t variable_cost(num_t *X, int nd)
+{
+    volatile num_t work = 0; /* keeps the dummy operations */
+    int i;
+    int n;
+
+    /* Smooth cost landscape, between 1x and 10x */
+    n = (int)(VC_WORK * (1 + 9 * (0.5 + 0.5 * sin(X[0]))));
+    for (i = 0; i < n; i++) {
+        work = work + 1.0;
+    }
+
+    return rastrigin(X, nd);
+}
+
+/*
+ * Rastrigin function, partial sums over a slice of the decision variables
+ * (see struct decomp_func_s): S = sum_j (x_j^2 - 10 cos(2 pi x_j)), P = 1
+ *
+ * Input parameters
+ * - X: n slices of input variables vectors, one every ld elements
+ * - n: number of slices
+ * - ld: distance (number of elements) between consecutive slices
+ * - j0: index of the first decision variable of the slices
+ * - nj: number of decision variables per slice
+ *
+ * Output parameters
+ * - sp: (S, P) pairs (length: 2 * n)
+ */
+void rastrigin_partial(num_t *X, int n, int ld, int j0, int nj, num_t *sp)
+{
+    int i, p;
+    acc_t x;
+    acc_t val;
 
-    a = sin(sqrt(X[0] * X[0] + X[1] * X[1])) *
-            sin(sqrt(X[0] * X[0] + X[1] * X[1])) -
-        0.5;
-    b = (1 + 0.001 * (X[0] * X[0] + X[1] * X[1])) *
-        (1 + 0.001 * (X[0] * X[0] + X[1] * X[1]));
+    for (p = 0; p < n; p++) {
+        val = 0;
+        for (i = 0; i < nj; i++) {
+            x = X[p * ld + i];
+            val += x * x - 10 * cos(2 * PI * x);
+        }
 
-    return -1.0*(0.5 + a / b);
+        sp[2 * p] = val;
+        sp[2 * p + 1] = 1;
+    }
 }
+
+/*
+ * Rastrigin function from the partial sums of all the decision variables
+ *
+ * Input parameters
+ * - sp: (S, P) pair
+ * - nd: number of decision variables
+ *
+ * Return value
+ * Function value
+ */
+num_t rastrigin_value(const num_t *sp, int nd)
+{
+    return -(10 * nd + (acc_t)sp[0]);
+}
+
+/*
+ * Rastrigin function gradient, slice of the decision variables
+ *
+ * Input parameters
+ * - X: slice of the input variables vector
+ * - j0: index of the first decision variable of the slice
+ * - nj: number of decision variables of the slice
+ * - p_other: product of the P outside the slice (unused)
+ *
+ * Output parameters
+ * - result: gradient slice (length: nj)
+ */
+void rastrigin_grad_partial(num_t *X, int j0, int nj, num_t p_other,
+                            num_t *result)
+{
+    rastrigin_grad(X, nj, result);
+}
+
+/*
+ * Griewangk function, partial sum and product over a slice of the decision
+ * variables (see struct decomp_func_s): S = sum_j x_j^2 / 4000,
+ * P = prod_j cos(x_j / sqrt(j + 1))
+ *
+ * Input parameters
+ * - X: n slices of input variables vectors, one every ld elements
+ * - n: number of slices
+ * - ld: distance (number of elements) between consecutive slices
+ * - j0: index of the first decision variable of the slices
+ * - nj: number of decision variables per slice
+ *
+ * Output parameters
+ * - sp: (S, P) pairs (length: 2 * n)
+ */
+void griewangk_partial(num_t *X, int n, int ld, int j0, int nj, num_t *sp)
+{
+    int i, p;
+    acc_t x;
+    acc_t a;
+    acc_t b;
+
+    for (p = 0; p < n; p++) {
+        a = 0.0;
+        b = 1.0;
+
+        for (i = 0; i < nj; i++) {
+            x = X[p * ld + i];
+            a += (x * x) / (acc_t)4000;
+            b *= cos(x / sqrt((acc_t)(j0 + i) + 1));
+        }
+
+        sp[2 * p] = a;
+        sp[2 * p + 1] = b;
+    }
+}
+
+/*
+ * Griewangk function from the partial sums and products of all the decision
+ * variables
+ *
+ * Input parameters
+ * - sp: (S, P) pair
+ * - nd: number of decision variables
+ *
+ * Return value
+ * Function value
+ */
+num_t griewangk_value(const num_t *sp, int nd)
+{
+    return -((acc_t)sp[0] - (acc_t)sp[1] + 1);
+}
+
+/*
+ * Griewangk function gradient, slice of the decision variables
+ *
+ * Input parameters
+ * - X: slice of the input variables vector
+ * - j0: index of the first decision variable of the slice
+ * - nj: number of decision variables of the slice
+ * - p_other: product of the cosine terms outside the slice
+ *
+ * Output parameters
+ * - result: gradient slice (length: nj)
+ */
+void griewangk_grad_partial(num_t *X, int j0, int nj, num_t p_other,
+                            num_t *result)
+{
+    int i;
+    acc_t x;
+    acc_t prod; /* running product of the cosine terms */
+
+    /* As in griewangk_grad(), starting from the product of the cosine terms
+     * of the other slices */
+    prod = p_other;
+    for (i = 0; i < nj; i++) {
+        result[i] = prod;
+        prod *= cos(X[i] / sqrt((acc_t)(j0 + i) + 1));
+    }
+
+    prod = 1.0;
+    for (i = nj - 1; i >= 0; i--) {
+        x = X[i];
+        result[i] = -(x / (acc_t)2000 + result[i] * prod *
+                                            sin(x / sqrt((acc_t)(j0 + i) + 1)) /
+                                            sqrt((acc_t)(j0 + i) + 1));
+        prod *= cos(x / sqrt((acc_t)(j0 + i) + 1));
+    }
+}
+
+/* Objective functions decomposed over the decision variables */
+const struct decomp_func_s rastrigin_decomp = {
+    rastrigin_partial, rastrigin_value, rastrigin_grad_partial, 0};
+const struct decomp_func_s griewangk_decomp = {
+    griewangk_partial, griewangk_value, griewangk_grad_partial, 1};
@@ -0,0 +1,763 @@
+/*
+ * Command line parsing.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+
+#include "sso.h"
+
+/*
+ * This function sets the default run options.
+ *
+ * Output parameters
+ * - opts: run options
+ */
+void init_run_opts(struct run_opts_s *opts)
+{
+    opts->np = 0;
+    opts->tc = 0;
+    opts->check_grad = 0;
+    opts->threads = 0;
+    opts->seed = 0;
+    opts->seed_set = 0;
+    opts->exchange = 0;
+    opts->target = 0;
+    opts->target_set = 0;
+    opts->dynamic = 0;
+    opts->reduce = REDUCE_AUTO;
+    opts->csv = 0;
+    opts->prof_json = NULL;
+    opts->checkpoint = NULL;
+    opts->checkpoint_every = CKPT_EVERY;
+    opts->restart = NULL;
+    opts->stop_window = 0;
+    opts->stop_tol = 0;
+    opts->stop_target = 0;
+    opts->plugin = NULL;
+    opts->expr = NULL;
+    opts->nd = 2;
+    opts->nd_set = 0;
+    opts->low = -20;
+    opts->high = 20;
+    opts->goal = MIN_GOAL;
+    opts->sweep = NULL;
+    opts->sweep_out = SWEEP_OUT;
+    opts->group_size = 1;
+    opts->generic = 0;
+    opts->decompose = 1;
+    opts->sim = NULL;
+    opts->sim_workers = SIM_WORKERS;
+    opts->cache = 0;
+    opts->grad_est = -1;
+    opts->grad_step = 0;
+    opts->spsa_draws = 1;
+    opts->shared = 0;
+    opts->top_k = 0;
+    opts->top_k_dist = -1;
+    opts->top_k_out = NULL;
+    opts->pop_flags = 0;
+}
+
+/*
+ * This function parses the command line (options followed by NP and TC, or
+ * options only with --sweep).
+ * Error messages are only printed by process 0.
+ *
+ * Input parameters
+ * - argc: number of arguments
+ * - argv: arguments
+ * - rank: process rank
+ *
+ * Output parameters
+ * - opts: run options
+ *
+ * Return value
+ * It returns -1 if the command line is not valid.
+ * It returns 1 on success.
+ */
+int parse_options(int argc, char *argv[], int rank, struct run_opts_s *opts)
+{
+    static struct option long_options[] = {
+        {"check-grad", no_argument, NULL, 'g'},
+        {"threads", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 's'},
+        {"exchange", required_argument, NULL, 'e'},
+        {"target", required_argument, NULL, 'T'},
+        {"dynamic", required_argument, NULL, 'd'},
+        {"reduce", required_argument, NULL, 'R'},
+        {"csv", no_argument, NULL, 'C'},
+        {"profile-json", required_argument, NULL, 'P'},
+        {"checkpoint", required_argument, NULL, 'K'},
+        {"checkpoint-every", required_argument, NULL, 'I'},
+        {"restart", required_argument, NULL, 'r'},
+        {"stop-window", required_argument, NULL, 'W'},
+        {"stop-tol", required_argument, NULL, 'O'},
+        {"stop-target", no_argument, NULL, 'A'},
+        {"plugin", required_argument, NULL, 'L'},
+        {"expr", required_argument, NULL, 'x'},
+        {"nd", required_argument, NULL, 'n'},
+        {"low", required_argument, NULL, 'l'},
+        {"high", required_argument, NULL, 'h'},
+        {"goal", required_argument, NULL, 'G'},
+        {"sweep", required_argument, NULL, 'S'},
+        {"sweep-out", required_argument, NULL, 'o'},
+        {"group-size", required_argument, NULL, 'z'},
+        {"generic", no_argument, NULL, 'k'},
+        {"decompose", required_argument, NULL, 'D'},
+        {"sim", required_argument, NULL, 'M'},
+        {"sim-workers", required_argument, NULL, 'w'},
+        {"cache", required_argument, NULL, 'c'},
+        {"grad", required_argument, NULL, 'E'},
+        {"grad-step", required_argument, NULL, 'H'},
+        {"spsa-draws", required_argument, NULL, 'Y'},
+        {"shared", no_argument, NULL, 'N'},
+        {"top-k", required_argument, NULL, 'B'},
+        {"top-k-dist", required_argument, NULL, 'Q'},
+        {"top-k-out", required_argument, NULL, 'U'},
+        {"layout", required_argument, NULL, 'y'},
+        {"hugepages", no_argument, NULL, 'u'},
+        {NULL, 0, NULL, 0}};
+    char *endptr; /* location of the first invalid char (strtol) */
+    int c;
+
+    init_run_opts(opts);
+
+    opterr = 0; /* error messages are printed below (process 0 only) */
+    while ((c = getopt_long(argc, argv, "gt:s:e:d:", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'g':
+            opts->check_grad = 1;
+            break;
+        case 't':
+            errno = 0;
+            opts->threads = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->threads < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of threads\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 's':
+            errno = 0;
+            opts->seed = (uint64_t)strtoull(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || *endptr != '\0') {
+                if (rank == 0) {
+                    printf("%s: error: invalid seed\n", argv[0]);
+                }
+                return -1;
+            }
+            opts->seed_set = 1;
+            break;
+        case 'e':
+            errno = 0;
+            opts->exchange = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->exchange < 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid exchange interval\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'T':
+            errno = 0;
+            opts->target = (num_t)strtod(optarg, &endptr);
+            if (errno != 0 || endptr == optarg) {
+                if (rank == 0) {
+                    printf("%s: error: invalid target\n", argv[0]);
+                }
+                return -1;
+            }
+            opts->target_set = 1;
+            break;
+        case 'd':
+            errno = 0;
+            opts->dynamic = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->dynamic < 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid chunk size\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'R':
+            if (strcmp(optarg, "auto") == 0) {
+                opts->reduce = REDUCE_AUTO;
+            } else if (strcmp(optarg, "op") == 0) {
+                opts->reduce = REDUCE_OP;
+            } else if (strcmp(optarg, "loc") == 0) {
+                opts->reduce = REDUCE_LOC;
+            } else {
+                if (rank == 0) {
+                    printf("%s: error: invalid reduction algorithm\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'C':
+            opts->csv = 1;
+            break;
+        case 'P':
+            opts->prof_json = optarg;
+            break;
+        case 'K':
+            opts->checkpoint = optarg;
+            break;
+        case 'I':
+            errno = 0;
+            opts->checkpoint_every = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg ||
+                opts->checkpoint_every <= 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid checkpoint interval\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'r':
+            opts->restart = optarg;
+            break;
+        case 'W':
+            errno = 0;
+            opts->stop_window = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->stop_window < 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid stagnation window\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'O':
+            errno = 0;
+            opts->stop_tol = (num_t)strtod(optarg, &endptr);
+            if (errno != 0 || endptr == optarg || opts->stop_tol < 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid improvement threshold\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'A':
+            opts->stop_target = 1;
+            break;
+        case 'L':
+            opts->plugin = optarg;
+            break;
+        case 'x':
+            opts->expr = optarg;
+            break;
+        case 'n':
+            errno = 0;
+            opts->nd = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->nd <= 0) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of decision "
+                           "variables\n", argv[0]);
+                }
+                return -1;
+            }
+            opts->nd_set = 1;
+            break;
+        case 'l':
+        case 'h':
+            errno = 0;
+            *(c == 'l' ? &opts->low : &opts->high) =
+                (num_t)strtod(optarg, &endptr);
+            if (errno != 0 || endptr == optarg) {
+                if (rank == 0) {
+                    printf("%s: error: invalid bound\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'G':
+            if (strcmp(optarg, "min") == 0) {
+                opts->goal = MIN_GOAL;
+            } else if (strcmp(optarg, "max") == 0) {
+                opts->goal = MAX_GOAL;
+            } else {
+                if (rank == 0) {
+                    printf("%s: error: invalid goal\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'S':
+            opts->sweep = optarg;
+            break;
+        case 'o':
+            opts->sweep_out = optarg;
+            break;
+        case 'z':
+            errno = 0;
+            opts->group_size = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->group_size < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid group size\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'k':
+            opts->generic = 1;
+            break;
+        case 'D':
+            errno = 0;
+            opts->decompose = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->decompose < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of processes per "
+                           "shark\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'M':
+            opts->sim = optarg;
+            break;
+        case 'w':
+            errno = 0;
+            opts->sim_workers = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->sim_workers < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of simulator "
+                           "workers\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'c':
+            errno = 0;
+            opts->cache = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->cache < 0 ||
+                opts->cache > (1 << 30)) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of cache slots\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'E':
+            opts->grad_est = gradient_estimator(optarg);
+            if (opts->grad_est == -1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid gradient estimator\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'H':
+            if (strcmp(optarg, "auto") == 0) {
+                opts->grad_step = GRAD_STEP_REL;
+                break;
+            }
+            errno = 0;
+            opts->grad_step = (num_t)strtod(optarg, &endptr);
+            if (errno != 0 || endptr == optarg || !(opts->grad_step > 0)) {
+                if (rank == 0) {
+                    printf("%s: error: invalid gradient step\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'Y':
+            errno = 0;
+            opts->spsa_draws = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->spsa_draws < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of SPSA draws\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'N':
+            opts->shared = 1;
+            break;
+        case 'y':
+            if (strcmp(optarg, "aos") == 0) {
+                opts->pop_flags &= ~POP_SOA;
+            } else if (strcmp(optarg, "soa") == 0) {
+                opts->pop_flags |= POP_SOA;
+            } else {
+                if (rank == 0) {
+                    printf("%s: error: invalid layout\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'u':
+            opts->pop_flags |= POP_HUGEPAGES;
+            break;
+        case 'B':
+            errno = 0;
+            opts->top_k = (int)strtol(optarg, &endptr, 10);
+            if (errno != 0 || endptr == optarg || opts->top_k < 1) {
+                if (rank == 0) {
+                    printf("%s: error: invalid number of solutions\n",
+                           argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'Q':
+            errno = 0;
+            opts->top_k_dist = (num_t)strtod(optarg, &endptr);
+            if (errno != 0 || endptr == optarg || !(opts->top_k_dist >= 0)) {
+                if (rank == 0) {
+                    printf("%s: error: invalid minimum distance\n", argv[0]);
+                }
+                return -1;
+            }
+            break;
+        case 'U':
+            opts->top_k_out = optarg;
+            break;
+        default:
+            if (rank == 0) {
+                printf("%s: error: invalid option '%s'\n", argv[0],
+                       argv[optind - 1]);
+            }
+            return -1;
+        }
+    }
+
+    /* Chunks are processed independently, without any exchange */
+    if (opts->dynamic > 0 && opts->exchange > 0) {
+        if (rank == 0) {
+            printf("%s: error: --dynamic and --exchange cannot be used "
+                   "together\n", argv[0]);
+        }
+        return -1;
+    }
+
+    if (opts->stop_target && !opts->target_set) {
+        if (rank == 0) {
+            printf("%s: error: --stop-target requires --target\n", argv[0]);
+        }
+        return -1;
+    }
+
+    if ((opts->plugin != NULL) + (opts->expr != NULL) + (opts->sim != NULL) >
+        1) {
+        if (rank == 0) {
+            printf("%s: error: --plugin, --expr and --sim cannot be used "
+                   "together\n", argv[0]);
+        }
+        return -1;
+    }
+    if ((opts->expr != NULL || opts->sim != NULL) &&
+        !(opts->low < opts->high)) {
+        if (rank == 0) {
+            printf("%s: error: --low must be lower than --high\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* Chunks are not kept in memory for the whole run */
+    if (opts->dynamic > 0 &&
+        (opts->checkpoint != NULL || opts->restart != NULL)) {
+        if (rank == 0) {
+            printf("%s: error: --dynamic cannot be used with --checkpoint "
+                   "or --restart\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* Each chunk runs on its own (MPI_COMM_SELF): the processes would not
+     * stop on the same iteration */
+    if (opts->dynamic > 0 && (opts->stop_window > 0 || opts->stop_target)) {
+        if (rank == 0) {
+            printf("%s: error: --dynamic cannot be used with --stop-window "
+                   "or --stop-target\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* Only the gradient, movements and evaluations are decomposed */
+    if (opts->decompose > 1 &&
+        (opts->dynamic > 0 || opts->exchange > 0 || opts->checkpoint != NULL ||
+         opts->restart != NULL || opts->stop_window > 0 || opts->stop_target ||
+         opts->plugin != NULL || opts->expr != NULL || opts->sim != NULL ||
+         opts->cache > 0)) {
+        if (rank == 0) {
+            printf("%s: error: --decompose cannot be used with --dynamic, "
+                   "--exchange, --checkpoint, --restart, --stop-window, "
+                   "--stop-target, --plugin, --expr, --sim or --cache\n",
+                   argv[0]);
+        }
+        return -1;
+    }
+
+    /* The blocks use the analytic gradient of the decomposition */
+    if (opts->decompose > 1 && (opts->grad_est != -1 || opts->grad_step > 0)) {
+        if (rank == 0) {
+            printf("%s: error: --decompose cannot be used with --grad or "
+                   "--grad-step\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* The solutions are taken from the whole population at the end */
+    if (opts->top_k == 0 &&
+        (opts->top_k_dist >= 0 || opts->top_k_out != NULL)) {
+        if (rank == 0) {
+            printf("%s: error: --top-k-dist and --top-k-out require "
+                   "--top-k\n", argv[0]);
+        }
+        return -1;
+    }
+    /* The shared window holds the populations of the static distribution */
+    if (opts->shared && (opts->dynamic > 0 || opts->decompose > 1)) {
+        if (rank == 0) {
+            printf("%s: error: --shared cannot be used with --dynamic or "
+                   "--decompose\n", argv[0]);
+        }
+        return -1;
+    }
+    if (opts->shared && (opts->pop_flags & POP_HUGEPAGES)) {
+        if (rank == 0) {
+            printf("%s: error: --hugepages cannot be used with --shared\n",
+                   argv[0]);
+        }
+        return -1;
+    }
+    if (opts->top_k > 0 && (opts->dynamic > 0 || opts->decompose > 1)) {
+        if (rank == 0) {
+            printf("%s: error: --top-k cannot be used with --dynamic or "
+                   "--decompose\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* Jobs only use the test cases and the static distribution */
+    if (opts->sweep != NULL &&
+        (opts->dynamic > 0 || opts->checkpoint != NULL ||
+         opts->restart != NULL || opts->plugin != NULL || opts->expr != NULL ||
+         opts->sim != NULL || opts->nd_set || opts->decompose > 1 ||
+         opts->shared || opts->top_k > 0)) {
+        if (rank == 0) {
+            printf("%s: error: --sweep cannot be used with --dynamic, "
+                   "--checkpoint, --restart, --plugin, --expr, --sim, --nd, "
+                   "--decompose, --shared or --top-k\n", argv[0]);
+        }
+        return -1;
+    }
+    if (opts->sweep != NULL) {
+        if (argc != optind) {
+            if (rank == 0) {
+                print_usage(argv[0]);
+            }
+            return -1;
+        }
+        return 1;
+    }
+
+    /* Check the number of positional arguments (no TC with a plugin, an
+     * expression or a simulator) */
+    if (argc - optind != (opts->plugin != NULL || opts->expr != NULL ||
+                                  opts->sim != NULL
+                              ? 1
+                              : 2)) {
+        if (rank == 0) {
+            print_usage(argv[0]);
+        }
+        return -1;
+    }
+
+    /* Set population size (check strtol errors) */
+    errno = 0;
+    opts->np = (int)strtol(argv[optind], &endptr, 10);
+    if (errno != 0 || endptr == argv[optind]) {
+        if (rank == 0) {
+            printf("%s: error: invalid NP parameter\n", argv[0]);
+        }
+        return -1;
+    }
+
+    /* Set test case (check strtol errors) */
+    if (opts->plugin != NULL || opts->expr != NULL || opts->sim != NULL) {
+        opts->tc = opts->plugin != NULL ? TC_PLUGIN
+                   : opts->expr != NULL ? TC_EXPR
+                                        : TC_SIM;
+        return 1;
+    }
+    errno = 0;
+    opts->tc = (int)strtol(argv[optind + 1], &endptr, 10);
+    if (errno != 0 || endptr == argv[optind + 1]) {
+        if (rank == 0) {
+            printf("%s: error: invalid TC parameter\n", argv[0]);
+        }
+        return -1;
+    }
+    if (opts->tc < 0 || opts->tc >= NUM_OF_TC) {
+        if (rank == 0) {
+            printf("%s: error: the selected test case does not exist\n",
+                   argv[0]);
+        }
+        return -1;
+    }
+
+    return 1;
+}
+
+/* Print usage information */
+void print_usage(char *name)
+{
+    printf("Usage: %s [OPTIONS] NP TC\n", name);
+    printf("       %s [OPTIONS] --plugin FILE NP\n", name);
+    printf("       %s [OPTIONS] --expr EXPR [--nd N] [--low L] [--high H] "
+           "[--goal G] NP\n", name);
+    printf("       %s [OPTIONS] --sim CMD [--sim-workers W] [--nd N] [--low L] "
+           "[--high H]\n", name);
+    printf("           [--goal G] NP\n");
+    printf("       %s [OPTIONS] --decompose G NP TC\n", name);
+    printf("       %s [OPTIONS] --sweep FILE [--group-size G] [--sweep-out "
+           "FILE]\n", name);
+    printf("NP: population size\n");
+    printf("TC: test case\n\n");
+    printf("TC is a number which can assume the following values:\n");
+    printf("0) Elliptic Paraboloid\n");
+    printf("1) Goldstein-Price function\n");
+    printf("2) \"Flipped\" Goldstein-Price function\n");
+    printf("3) Rastrigin function (two decision variables)\n");
+    printf("4) Rastrigin function (five decision variables)\n");
+    printf("5) Griewangk function (two decision variables)\n");
+    printf("6) Griewangk function (five decision variables)\n");
+    printf("7) Schaffer function\n");
+    printf("8) Rastrigin function with variable evaluation cost (five "
+           "decision variables)\n\n");
+    printf("OPTIONS:\n");
+    printf("--generic         always use the generic solver kernel (default: "
+           "kernels\n");
+    printf("                  specialized for nd and objective function when "
+           "available)\n");
+    printf("-g, --check-grad  compare the analytic gradient with finite "
+           "differences\n");
+    printf("                  at random points (fall back to finite "
+           "differences on\n");
+    printf("                  mismatch)\n");
+    printf("-t, --threads N   number of threads per process (default: "
+           "OMP_NUM_THREADS)\n");
+    printf("-s, --seed S      PRNG seed (default: current time); results do "
+           "not\n");
+    printf("                  depend on the number of processes and "
+           "threads\n");
+    printf("-e, --exchange N  share the global best among processes every N\n");
+    printf("                  iterations (default: 0, never)\n");
+    printf("--target VAL      report the iterations needed to reach VAL\n");
+    printf("-d, --dynamic C   hand out chunks of C sharks on demand "
+           "(process 0 is\n");
+    printf("                  the master) instead of splitting the "
+           "population\n");
+    printf("                  statically\n");
+    printf("--reduce ALG      best solution reduction: loc (MPI_MINLOC/"
+           "MPI_MAXLOC on\n");
+    printf("                  the value, then the owner sends the vector), "
+           "op (custom\n");
+    printf("                  operation on the whole vector) or auto (loc "
+           "if nd >= %d,\n", REDUCE_LOC_MIN_ND);
+    printf("                  default)\n");
+    printf("--csv             also print the line \"csv,TC,NP,processes,"
+           "threads,\n");
+    printf("                  elapsed time,evaluations,evaluations per "
+           "second,best\n");
+    printf("                  value,iterations\"\n");
+    printf("--profile-json F  write the per-phase profile to F as JSON "
+           "(builds with\n");
+    printf("                  PROFFLAGS=-DSSO_PROFILE only)\n");
+    printf("--checkpoint F    save the population to F every "
+           "--checkpoint-every\n");
+    printf("                  iterations (default: %d)\n", CKPT_EVERY);
+    printf("--restart F       resume from checkpoint F (same NP and TC, any "
+           "number of\n");
+    printf("                  processes)\n");
+    printf("--stop-window W   stop when the global best improved by at most "
+           "--stop-tol\n");
+    printf("                  (relative, default: 0) in the last W "
+           "iterations\n");
+    printf("--stop-target     stop when the global best reaches --target\n");
+    printf("--plugin FILE     optimize the objective function of the shared "
+           "object\n");
+    printf("                  FILE (see sso_plugin.h) instead of a test "
+           "case\n");
+    printf("--expr EXPR       optimize the function of x[0..nd-1] given by "
+           "EXPR, e.g.\n");
+    printf("                  \"10 * nd + sum(i, x[i]^2 - 10 * cos(2 * pi * "
+           "x[i]))\"\n");
+    printf("--sim CMD         optimize the function computed by simulator "
+           "workers running\n");
+    printf("                  the shell command CMD (see sso_sim.h), e.g. "
+           "\"sim/of_sim\n");
+    printf("                  rastrigin 1000\"\n");
+    printf("--sim-workers W   simulator workers per process, split among "
+           "the threads\n");
+    printf("                  (default: %d)\n", SIM_WORKERS);
+    printf("--cache N         look the points up in a cache of N "
+           "evaluations per thread\n");
+    printf("                  before evaluating them (exact matches, "
+           "generic kernel)\n");
+    printf("--grad EST        gradient estimator: analytic (default when "
+           "available),\n");
+    printf("                  central (2 nd evaluations, default otherwise), "
+           "forward\n");
+    printf("                  (nd, reusing f(X)) or spsa (2 per draw, any "
+           "nd)\n");
+    printf("--grad-step S     finite differences step (SPSA: initial "
+           "perturbation) as a\n");
+    printf("                  fraction of high - low, or auto (%g; "
+           "default: %g)\n", GRAD_STEP_REL, D_INCR);
+    printf("--spsa-draws K    random directions averaged by the spsa "
+           "estimator (default: 1)\n");
+    printf("--nd N            decision variables of EXPR or CMD (default: 2) "
+           "or of test\n");
+    printf("                  cases 3, 4, 5, 6 and 8\n");
+    printf("--low L, --high H decision variables bounds of EXPR or CMD "
+           "(default: -20, 20)\n");
+    printf("--goal G          min (default) or max\n");
+    printf("--shared          allocate the populations of the processes of "
+           "each node in\n");
+    printf("                  a shared memory window and combine their "
+           "best solutions on\n");
+    printf("                  the node before the exchanges and the "
+           "reduction among the\n");
+    printf("                  nodes (not with --dynamic or --decompose)\n");
+    printf("--layout L        population layout: aos (one record per shark, "
+           "default) or\n");
+    printf("                  soa (one block of rows per field)\n");
+    printf("--hugepages       align the population to %d MB and ask for "
+           "transparent huge\n", HUGE_PAGE / (1024 * 1024));
+    printf("                  pages (not with --shared)\n");
+    printf("--top-k K         report the K best distinct solutions of the "
+           "final population\n");
+    printf("--top-k-dist D    minimum euclidean distance between two of "
+           "them (default:\n");
+    printf("                  %g (high - low))\n", TOPK_DIST_REL);
+    printf("--top-k-out FILE  save them to the CSV file FILE instead of "
+           "printing them\n");
+    printf("--sweep FILE      run every job \"NP TC [SEED [ETA ALPHA BETA]]\" "
+           "of FILE (one\n");
+    printf("                  per line) on groups of processes, handed out "
+           "on demand by\n");
+    printf("                  process 0\n");
+    printf("--group-size G    processes per group (default: 1)\n");
+    printf("--sweep-out FILE  results of the jobs (default: %s)\n",
+           SWEEP_OUT);
+    printf("--decompose G     split the decision variables of each shark "
+           "among G\n");
+    printf("                  processes (groups of G processes share a part "
+           "of the\n");
+    printf("                  population; test cases 3, 4, 5 and 6)\n\n");
+    fflush(stdout);
+}
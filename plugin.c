@@ -0,0 +1,90 @@
+/*
+ * Objective function plugins (shared objects loaded at runtime).
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stddef.h>
+#include <dlfcn.h>
+
+#include "sso.h"
+#include "sso_plugin.h"
+
+/*
+ * This function loads a plugin and fills the test case parameters with its
+ * descriptor. The function pointers are resolved once here, so that the
+ * solver calls them directly.
+ *
+ * Input parameters
+ * - path: shared object file
+ *
+ * Output parameters
+ * - tc_params: test case parameters
+ * - name: objective function name (owned by the plugin)
+ * - handle: handle to pass to plugin_close()
+ *
+ * Return value
+ * It returns -1 if the shared object or its descriptor could not be loaded
+ * (dlerror() tells why).
+ * It returns -2 if the descriptor is not valid.
+ * It returns 1 on success.
+ */
+int plugin_load(const char *path, struct tc_params_s *tc_params,
+                const char **name, void **handle)
+{
+    const struct sso_plugin_s *desc; /* plugin descriptor */
+
+    *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (*handle == NULL) {
+        return -1;
+    }
+
+    desc = (const struct sso_plugin_s *)dlsym(*handle, SSO_PLUGIN_SYMBOL);
+    if (desc == NULL) {
+        dlclose(*handle);
+        return -1;
+    }
+
+    if (desc->abi != SSO_PLUGIN_ABI || desc->num_size != sizeof(num_t) ||
+        desc->nd <= 0 || !(desc->low < desc->high) ||
+        (desc->goal != SSO_PLUGIN_MIN && desc->goal != SSO_PLUGIN_MAX) ||
+        desc->m_points <= 0 || desc->k_max <= 0 || desc->obj_func == NULL) {
+        dlclose(*handle);
+        return -2;
+    }
+
+    *name = desc->name != NULL ? desc->name : path;
+    tc_params->nd = desc->nd;
+    tc_params->low = desc->low;
+    tc_params->high = desc->high;
+    tc_params->goal = desc->goal == SSO_PLUGIN_MIN ? MIN_GOAL : MAX_GOAL;
+    tc_params->obj_func = desc->obj_func;
+    tc_params->obj_func_batch = desc->obj_func_batch;
+    tc_params->grad_func = desc->grad_func;
+    tc_params->eta = desc->eta;
+    tc_params->alpha = desc->alpha;
+    tc_params->beta = desc->beta;
+    tc_params->delta_t = desc->delta_t;
+    tc_params->m_points = desc->m_points;
+    tc_params->k_max = desc->k_max;
+    tc_params->initial_velocity = desc->initial_velocity;
+    tc_params->decomp = NULL;
+    tc_params->any_nd = 0;
+    tc_params->grad_est =
+        desc->grad_func != NULL ? GRAD_ANALYTIC : GRAD_CENTRAL;
+    tc_params->grad_step = D_INCR;
+    tc_params->spsa_draws = 1;
+
+    return 1;
+}
+
+/*
+ * This function unloads a plugin.
+ *
+ * Input parameters
+ * - handle: handle returned by plugin_load()
+ */
+void plugin_close(void *handle)
+{
+    dlclose(handle);
+}
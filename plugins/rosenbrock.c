@@ -0,0 +1,104 @@
+/*
+ * Example objective function plugin: Rosenbrock function (four decision
+ * variables).
+ * Build with: make plugins/rosenbrock.so
+ * Run with: mpirun -n 4 ./sso --plugin plugins/rosenbrock.so NP
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include "sso_plugin.h"
+
+/*
+ * Rosenbrock function
+ * Goal: minimization
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Return value
+ * Function value at a given point (changed in sign)
+ */
+static sso_num_t rosenbrock(sso_num_t *X, int nd)
+{
+    sso_num_t f = 0;
+    sso_num_t a, b;
+    int i;
+
+    for (i = 0; i < nd - 1; i++) {
+        a = X[i + 1] - X[i] * X[i];
+        b = 1 - X[i];
+        f += 100 * a * a + b * b;
+    }
+
+    return -f;
+}
+
+/*
+ * Rosenbrock function (batched version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+static void rosenbrock_batch(sso_num_t *X, int n, int nd, int ld,
+                             sso_num_t *result)
+{
+    int p;
+
+    for (p = 0; p < n; p++) {
+        result[p] = rosenbrock(&X[p * ld], nd);
+    }
+}
+
+/*
+ * Rosenbrock function gradient
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Output parameters
+ * - result: gradient at a given point (length: nd, changed in sign)
+ */
+static void rosenbrock_grad(sso_num_t *X, int nd, sso_num_t *result)
+{
+    sso_num_t a;
+    int i;
+
+    for (i = 0; i < nd; i++) {
+        result[i] = 0;
+    }
+    for (i = 0; i < nd - 1; i++) {
+        a = X[i + 1] - X[i] * X[i];
+        result[i] -= -400 * X[i] * a - 2 * (1 - X[i]);
+        result[i + 1] -= 200 * a;
+    }
+}
+
+/* Plugin descriptor */
+struct sso_plugin_s sso_plugin = {
+    .abi = SSO_PLUGIN_ABI,
+    .num_size = sizeof(sso_num_t),
+    .name = "Rosenbrock function (four decision variables)",
+    .nd = 4,
+    .low = -2.048,
+    .high = 2.048,
+    .goal = SSO_PLUGIN_MIN,
+    .eta = 0.0005,
+    .alpha = 0.1,
+    .beta = 4,
+    .delta_t = 1,
+    .m_points = 20,
+    .k_max = 30,
+    .initial_velocity = 0.5,
+    .obj_func = rosenbrock,
+    .obj_func_batch = rosenbrock_batch,
+    .grad_func = rosenbrock_grad,
+};
@@ -0,0 +1,110 @@
+/*
+ * Per-phase profile merge and cross-process report.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sso.h"
+
+/* Phase names (report and JSON keys) */
+static const char *phase_names[PROF_PHASES] = {
+    "gradient", "update", "rotate", "eval",
+    "select",   "exchange", "barrier", "reduce"};
+
+/*
+ * This function adds a profile to another one.
+ *
+ * Input parameters
+ * - dst: profile to update
+ * - src: profile to add
+ *
+ * Output parameters
+ * - dst: dst + src
+ */
+void prof_merge(struct prof_s *dst, const struct prof_s *src)
+{
+    int p;
+
+    for (p = 0; p < PROF_PHASES; p++) {
+        dst->time[p] += src->time[p];
+        dst->calls[p] += src->calls[p];
+        dst->evals[p] += src->evals[p];
+    }
+}
+
+/*
+ * This function reduces the profiles of the processes in comm and lets
+ * process 0 print, for every phase, the total number of timed sections and
+ * evaluations, the min/mean/max time over the processes and the load
+ * imbalance (max / mean - 1). Every process in comm must call it.
+ *
+ * Input parameters
+ * - prof: local profile
+ * - comm: communicator
+ * - json_file: if not NULL, process 0 also writes the report to this file as
+ *   JSON
+ *
+ * Return value
+ * It returns -1 if json_file could not be written (process 0 only).
+ * It returns 1 on success.
+ */
+int prof_report(const struct prof_s *prof, MPI_Comm comm,
+                const char *json_file)
+{
+    double t_min[PROF_PHASES], t_max[PROF_PHASES], t_sum[PROF_PHASES];
+    long long calls[PROF_PHASES], evals[PROF_PHASES];
+    double mean;
+    int rank, size, p;
+    FILE *f;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    MPI_Reduce(prof->time, t_min, PROF_PHASES, MPI_DOUBLE, MPI_MIN, 0, comm);
+    MPI_Reduce(prof->time, t_max, PROF_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(prof->time, t_sum, PROF_PHASES, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(prof->calls, calls, PROF_PHASES, MPI_LONG_LONG, MPI_SUM, 0,
+               comm);
+    MPI_Reduce(prof->evals, evals, PROF_PHASES, MPI_LONG_LONG, MPI_SUM, 0,
+               comm);
+
+    if (rank != 0) {
+        return 1;
+    }
+
+    printf("\nProfile (seconds summed over threads, per process):\n");
+    printf("%-10s %12s %12s %12s %12s %12s %10s\n", "phase", "calls", "evals",
+           "min", "mean", "max", "imbalance");
+    for (p = 0; p < PROF_PHASES; p++) {
+        mean = t_sum[p] / size;
+        printf("%-10s %12lld %12lld %12.6f %12.6f %12.6f %9.1f%%\n",
+               phase_names[p], calls[p], evals[p], t_min[p], mean, t_max[p],
+               mean > 0 ? 100.0 * (t_max[p] / mean - 1) : 0.0);
+    }
+
+    if (json_file == NULL) {
+        return 1;
+    }
+
+    f = fopen(json_file, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    fprintf(f, "{\"processes\": %d, \"threads\": %d, \"phases\": [", size,
+            max_threads());
+    for (p = 0; p < PROF_PHASES; p++) {
+        mean = t_sum[p] / size;
+        fprintf(f,
+                "%s\n  {\"name\": \"%s\", \"calls\": %lld, \"evals\": %lld, "
+                "\"time_min\": %.9e, \"time_mean\": %.9e, \"time_max\": %.9e, "
+                "\"imbalance\": %.6f}",
+                p > 0 ? "," : "", phase_names[p], calls[p], evals[p], t_min[p],
+                mean, t_max[p], mean > 0 ? t_max[p] / mean - 1 : 0.0);
+    }
+    fprintf(f, "\n]}\n");
+
+    return fclose(f) == 0 ? 1 : -1;
+}
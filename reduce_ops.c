@@ -5,7 +5,9 @@
  */
 #include "sso.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "mpi.h"
 
@@ -25,25 +27,16 @@
  */
 void find_max_val(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
 {
-    int ni; /* # of input integers used in the call constructing combiner */
-    int na; /* # of input addresses used in the call constructing combiner */
-    int nd; /* # of input datatypes used in the call constructing combiner */
-    int combiner;  /* combiner: reflects the MPI data type constructor call */
-    int i[1];      /* integer arguments used in constructing datatype */
-    MPI_Aint a[1]; /* address arguments used in constructing datatype */
-    MPI_Datatype d[1]; /* datatype arguments used in constructing datatype */
+    int dt_size;       /* datatype size (bytes) */
     num_t max_val;     /* current maximum value */
     int max_val_idx;   /* index of max value inside input vector */
     num_t *in = (num_t *)in_param;
     num_t *inout = (num_t *)inout_param;
 
-    /* Get datatype information. For a contiguous datatype we have ni = 1, na =
-     * 0, nd = 1. The information we need is the number of elements in the
-     * solution vector, so we can get the index of the maximum value in the
-     * array (last element). */
-    MPI_Type_get_envelope(*dt, &ni, &na, &nd, &combiner);
-    MPI_Type_get_contents(*dt, ni, na, nd, i, a, d);
-    max_val_idx = i[0] - 1; /* (nd+1) - 1 */
+    /* The datatype is a contiguous vector of nd+1 num_t elements: its size
+     * gives the index of the maximum value in the array (last element) */
+    MPI_Type_size(*dt, &dt_size);
+    max_val_idx = dt_size / (int)sizeof(num_t) - 1; /* (nd+1) - 1 */
 
     /* NOTE: *len = 1 because we passed a single element of type row_result_type
      * from the caller */
@@ -73,25 +66,16 @@ void find_max_val(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
  */
 void find_min_val(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
 {
-    int ni; /* # of input integers used in the call constructing combiner */
-    int na; /* # of input addresses used in the call constructing combiner */
-    int nd; /* # of input datatypes used in the call constructing combiner */
-    int combiner;  /* combiner: reflects the MPI data type constructor call */
-    int i[1];      /* integer arguments used in constructing datatype */
-    MPI_Aint a[1]; /* address arguments used in constructing datatype */
-    MPI_Datatype d[1]; /* datatype arguments used in constructing datatype */
+    int dt_size;       /* datatype size (bytes) */
     num_t min_val;     /* current minimum value */
     int min_val_idx;   /* index of min value inside input vector */
     num_t *in = (num_t *)in_param;
     num_t *inout = (num_t *)inout_param;
 
-    /* Get datatype information. For a contiguous datatype we have ni = 1, na =
-     * 0, nd = 1. The information we need is the number of elements in the
-     * solution vector, so we can get the index of the minimum value in the
-     * array (last element). */
-    MPI_Type_get_envelope(*dt, &ni, &na, &nd, &combiner);
-    MPI_Type_get_contents(*dt, ni, na, nd, i, a, d);
-    min_val_idx = i[0] - 1; /* (nd+1) - 1 */
+    /* The datatype is a contiguous vector of nd+1 num_t elements: its size
+     * gives the index of the minimum value in the array (last element) */
+    MPI_Type_size(*dt, &dt_size);
+    min_val_idx = dt_size / (int)sizeof(num_t) - 1; /* (nd+1) - 1 */
 
     /* NOTE: *len = 1 because we passed a single element of type row_result_type
      * from the caller */
@@ -104,3 +88,322 @@ void find_min_val(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
         memcpy(inout, in, (min_val_idx + 1) * sizeof(num_t));
     }
 }
+
+/*
+ * This function implements the reduce operation of the partial objective
+ * function values of a decomposed objective function (decomp.c): each element
+ * is a (S, P) pair of num_t, the S are added and the P multiplied.
+ * Note that inout_param is both an input and an output parameter.
+ *
+ * Input parameters
+ * - in_param: array of len pairs (first operand)
+ * - inout_param: array of len pairs (second operand)
+ * - len: # of pairs in the comm buffers (in_param and inout_param)
+ * - dt: datatype (contiguous pair of NUM_DT)
+ *
+ * Output parameters
+ * -inout_param: array of len pairs
+ */
+void sum_prod(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
+{
+    int i;
+    num_t *in = (num_t *)in_param;
+    num_t *inout = (num_t *)inout_param;
+
+    for (i = 0; i < *len; i++) {
+        inout[2 * i] += in[2 * i];
+        inout[2 * i + 1] *= in[2 * i + 1];
+    }
+}
+
+/* Keyval of the struct topk_s attribute of the top-K list datatypes */
+static int topk_keyval = MPI_KEYVAL_INVALID;
+
+/* candidate struct (topk_select()) */
+struct topk_cand_s {
+    num_t val; /* objective function value (maximized) */
+    int idx;   /* row index */
+};
+
+/* Decreasing value order (ties: increasing row index) */
+static int cmp_cand(const void *a, const void *b)
+{
+    const struct topk_cand_s *x = (const struct topk_cand_s *)a;
+    const struct topk_cand_s *y = (const struct topk_cand_s *)b;
+
+    if (x->val != y->val) {
+        return x->val > y->val ? -1 : 1;
+    }
+    return x->idx - y->idx;
+}
+
+/* Whether X (nd values) is farther than dist from the first n rows of a
+ * top-K list */
+static int is_distinct(const num_t *list, int n, const num_t *X, int nd,
+                       num_t dist)
+{
+    const num_t *row;
+    double d2, diff;
+    int r, j;
+
+    for (r = 0; r < n; r++) {
+        row = &list[(size_t)r * (nd + 1)];
+        d2 = 0;
+        for (j = 0; j < nd; j++) {
+            diff = (double)row[j] - X[j];
+            d2 += diff * diff;
+        }
+        if (d2 <= (double)dist * dist) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * This function implements the reduce operation of the top-K distinct
+ * solutions: the two sorted lists are merged by decreasing value, and a row
+ * is kept only if it is farther than the minimum distance from the rows
+ * already kept, until K rows are kept (greedy selection). The list length,
+ * nd and the minimum distance come from the struct topk_s attribute of the
+ * datatype (see topk_init()). The operation is not commutative (ties: rows
+ * of in_param, i.e. of the lower ranks, first), so that the result does not
+ * depend on the reduction tree. With a minimum distance of 0 (exact
+ * duplicates only) it is the greedy selection over all the rows; otherwise a
+ * row dropped by a partial list, because it is close to a row dropped itself
+ * at a later stage, is not recovered.
+ * Note that inout_param is both an input and an output parameter.
+ *
+ * Input parameters
+ * - in_param: array of len lists (first operand)
+ * - inout_param: array of len lists (second operand)
+ * - len: # of lists in the comm buffers (in_param and inout_param)
+ * - dt: datatype (topk_s type)
+ *
+ * Output parameters
+ * -inout_param: array of len lists
+ */
+void merge_topk(void *in_param, void *inout_param, int *len, MPI_Datatype *dt)
+{
+    struct topk_s *t;
+    int flag;
+    int row;        /* values per row */
+    num_t *a, *b;   /* lists to merge */
+    const num_t *x; /* next row */
+    int i, j, n, e;
+
+    MPI_Type_get_attr(*dt, topk_keyval, &t, &flag);
+    row = t->nd + 1;
+
+    for (e = 0; e < *len; e++) {
+        a = (num_t *)in_param + (size_t)e * t->k * row;
+        b = (num_t *)inout_param + (size_t)e * t->k * row;
+
+        for (i = 0, j = 0, n = 0; n < t->k;) {
+            if (i < t->k && a[(size_t)i * row + t->nd] != -INFINITY &&
+                (j == t->k || a[(size_t)i * row + t->nd] >=
+                                  b[(size_t)j * row + t->nd])) {
+                x = &a[(size_t)i++ * row];
+            } else if (j < t->k && b[(size_t)j * row + t->nd] != -INFINITY) {
+                x = &b[(size_t)j++ * row];
+            } else {
+                break;
+            }
+
+            if (is_distinct(t->merge, n, x, t->nd, t->dist)) {
+                memcpy(&t->merge[(size_t)n++ * row], x, row * sizeof(num_t));
+            }
+        }
+
+        for (; n < t->k; n++) {
+            t->merge[(size_t)n * row + t->nd] = -INFINITY;
+        }
+        memcpy(b, t->merge, (size_t)t->k * row * sizeof(num_t));
+    }
+}
+
+/*
+ * This function sets up the top-K distinct solutions reduction: list
+ * buffers, datatype (with t as attribute, so t must not be moved until
+ * topk_free()) and reduce operation (merge_topk()).
+ *
+ * Input parameters
+ * - k: number of solutions
+ * - nd: number of decision variables
+ * - dist: minimum (euclidean) distance between two solutions
+ *
+ * Output parameters
+ * - t: top-K reduction
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int topk_init(struct topk_s *t, int k, int nd, num_t dist)
+{
+    size_t len = (size_t)k * (nd + 1);
+
+    t->k = k;
+    t->nd = nd;
+    t->dist = dist;
+    t->local = (num_t *)malloc(len * sizeof(num_t));
+    t->result = (num_t *)malloc(len * sizeof(num_t));
+    t->merge = (num_t *)malloc(len * sizeof(num_t));
+    if (t->local == NULL || t->result == NULL || t->merge == NULL) {
+        free(t->local);
+        free(t->result);
+        free(t->merge);
+        return -1;
+    }
+
+    if (topk_keyval == MPI_KEYVAL_INVALID) {
+        MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, MPI_TYPE_NULL_DELETE_FN,
+                               &topk_keyval, NULL);
+    }
+    MPI_Type_contiguous((int)len, NUM_DT, &t->type);
+    MPI_Type_commit(&t->type);
+    MPI_Type_set_attr(t->type, topk_keyval, t);
+    MPI_Op_create((MPI_User_function *)&merge_topk, 0, &t->op);
+
+    return 1;
+}
+
+/*
+ * This function builds the top-K list of a set of solutions (greedy: by
+ * decreasing value, skipping the solutions closer than the minimum distance
+ * to one already kept).
+ *
+ * Input parameters
+ * - t: top-K reduction
+ * - X: decision variables of the solutions (n rows)
+ * - vals: objective function values of the solutions (maximized, n)
+ * - n: number of solutions
+ *
+ * Output parameters
+ * - t: list of this process (local)
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int topk_select(struct topk_s *t, num_t **X, const num_t *vals, int n)
+{
+    struct topk_cand_s *cand;
+    int row = t->nd + 1;
+    int i, kept;
+
+    cand = (struct topk_cand_s *)malloc(MAX(n, 1) * sizeof(*cand));
+    if (cand == NULL) {
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        cand[i].val = vals[i];
+        cand[i].idx = i;
+    }
+    qsort(cand, n, sizeof(*cand), cmp_cand);
+
+    for (i = 0, kept = 0; i < n && kept < t->k; i++) {
+        if (is_distinct(t->local, kept, X[cand[i].idx], t->nd, t->dist)) {
+            memcpy(&t->local[(size_t)kept * row], X[cand[i].idx],
+                   t->nd * sizeof(num_t));
+            t->local[(size_t)kept++ * row + t->nd] = cand[i].val;
+        }
+    }
+    for (; kept < t->k; kept++) {
+        t->local[(size_t)kept * row + t->nd] = -INFINITY;
+    }
+
+    free(cand);
+    return 1;
+}
+
+/*
+ * This function frees the buffers, datatype and reduce operation of a top-K
+ * reduction.
+ *
+ * Input parameters
+ * - t: top-K reduction
+ */
+void topk_free(struct topk_s *t)
+{
+    MPI_Type_free(&t->type);
+    MPI_Op_free(&t->op);
+    free(t->local);
+    free(t->result);
+    free(t->merge);
+}
+
+/*
+ * This function reduces the best solution among the processes in a
+ * communicator. Only the (value, rank) pair goes through the reduction
+ * (MPI_MINLOC / MPI_MAXLOC), then the winning vector is sent once by its owner
+ * to the root.
+ *
+ * Input parameters
+ * - solution: local solution vector with its OF value in the last position
+ *   (length: nd+1)
+ * - nd: number of decision variables
+ * - goal: MIN_GOAL / MAX_GOAL
+ * - root: rank of the root process
+ * - comm: communicator
+ *
+ * Output parameters
+ * - result: best solution vector (length: nd+1, significant at root only)
+ */
+void reduce_best(num_t *solution, num_t *result, int nd, int goal, int root,
+                 MPI_Comm comm)
+{
+    struct val_rank_s local;
+    struct val_rank_s best;
+
+    MPI_Comm_rank(comm, &local.rank);
+    local.val = solution[nd];
+
+    /* Every process needs the owner, so that it knows whether to send */
+    MPI_Allreduce(&local, &best, 1, NUM_INT_DT,
+                  goal == MIN_GOAL ? MPI_MINLOC : MPI_MAXLOC, comm);
+
+    if (best.rank == local.rank) {
+        if (local.rank == root) {
+            memcpy(result, solution, (nd + 1) * sizeof(num_t));
+        } else {
+            MPI_Send(solution, nd + 1, NUM_DT, root, 0, comm);
+        }
+    } else if (local.rank == root) {
+        MPI_Recv(result, nd + 1, NUM_DT, best.rank, 0, comm,
+                 MPI_STATUS_IGNORE);
+    }
+}
+
+/*
+ * This function works like reduce_best(), but every process gets the best
+ * solution (the owner broadcasts it).
+ *
+ * Input parameters
+ * - solution: local solution vector with its OF value in the last position
+ *   (length: nd+1)
+ * - nd: number of decision variables
+ * - goal: MIN_GOAL / MAX_GOAL
+ * - comm: communicator
+ *
+ * Output parameters
+ * - result: best solution vector (length: nd+1)
+ */
+void allreduce_best(num_t *solution, num_t *result, int nd, int goal,
+                    MPI_Comm comm)
+{
+    struct val_rank_s local;
+    struct val_rank_s best;
+
+    MPI_Comm_rank(comm, &local.rank);
+    local.val = solution[nd];
+
+    MPI_Allreduce(&local, &best, 1, NUM_INT_DT,
+                  goal == MIN_GOAL ? MPI_MINLOC : MPI_MAXLOC, comm);
+
+    if (best.rank == local.rank && result != solution) {
+        memcpy(result, solution, (nd + 1) * sizeof(num_t));
+    }
+    MPI_Bcast(result, nd + 1, NUM_DT, best.rank, comm);
+}
@@ -0,0 +1,129 @@
+/*
+ * Counter-based pseudo-random number generation (Philox4x32-10).
+ *
+ * Every draw is a pure function of (seed, stream, shark, iteration, draw
+ * index), so results do not depend on how sharks are distributed among
+ * processes and threads, nor on the order in which they are processed.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdint.h>
+
+#include "sso.h"
+
+/* Philox4x32 multipliers and Weyl sequence constants */
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+/* Conversion of a random word to [0,1): the top 24 bits in single precision
+ * (the 32-bit conversion rounds the words close to 2^32 up to 1.0f) */
+#if defined(SSO_FLOAT) || defined(SSO_MIXED)
+#define WORD_TO_UNIFORM(w) ((num_t)((w) >> 8) * 0x1p-24f)
+#else
+#define WORD_TO_UNIFORM(w) ((w) * 0x1p-32)
+#endif
+
+/*
+ * This function computes the Philox4x32-10 bijection of a counter under a key.
+ *
+ * Input parameters
+ * - ctr: counter (4 words)
+ * - key: key (2 words)
+ *
+ * Output parameters
+ * - out: random words (4 words)
+ */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    uint64_t p0, p1;
+    int r;
+
+    for (r = 0; r < PHILOX_ROUNDS; r++) {
+        p0 = (uint64_t)PHILOX_M0 * c0;
+        p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/*
+ * This function fills a vector with n uniformly distributed numbers in [0,1).
+ * Draw d of a (seed, stream, shark, iter) sequence is word d % 4 of the Philox
+ * block whose counter is (d / 4, iter, shark, stream), so any sub-range of a
+ * sequence can be generated independently.
+ *
+ * Input parameters
+ * - seed: seed (key)
+ * - stream: RNG_STREAM_* identifier
+ * - shark: global shark index
+ * - iter: iteration
+ * - first: index of the first draw
+ * - n: number of draws
+ *
+ * Output parameters
+ * - out: random numbers (length: n)
+ */
+void rng_fill_uniform(uint64_t seed, uint32_t stream, uint32_t shark,
+                      uint32_t iter, uint32_t first, int n, num_t *out)
+{
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t words[4];
+    uint32_t d;
+    int i = 0;
+
+    key[0] = (uint32_t)seed;
+    key[1] = (uint32_t)(seed >> 32);
+    ctr[1] = iter;
+    ctr[2] = shark;
+    ctr[3] = stream;
+
+    while (i < n) {
+        d = first + (uint32_t)i;
+        ctr[0] = d / 4;
+        philox4x32(ctr, key, words);
+
+        for (d = d % 4; d < 4 && i < n; d++, i++) {
+            out[i] = WORD_TO_UNIFORM(words[d]);
+        }
+    }
+}
+
+/*
+ * This function returns a single uniformly distributed number in [0,1) (see
+ * rng_fill_uniform()).
+ *
+ * Input parameters
+ * - seed: seed (key)
+ * - stream: RNG_STREAM_* identifier
+ * - shark: global shark index
+ * - iter: iteration
+ * - draw: draw index
+ *
+ * Return value
+ * Random number in [0,1)
+ */
+num_t rng_uniform(uint64_t seed, uint32_t stream, uint32_t shark,
+                  uint32_t iter, uint32_t draw)
+{
+    num_t r;
+
+    rng_fill_uniform(seed, stream, shark, iter, draw, 1, &r);
+
+    return r;
+}
@@ -0,0 +1,390 @@
+/*
+ * Objective functions computed by simulator workers.
+ *
+ * Every process starts a pool of long-lived worker processes running the
+ * --sim command (see sso_sim.h for the protocol), connected to it by a pair
+ * of pipes. The workers are split among the threads, each thread owning a
+ * contiguous range of them. A batch of points (gradient stencil, forward and
+ * rotational candidates) is split into contiguous requests, one per worker
+ * of the calling thread; all the requests are sent before the responses are
+ * collected, in order of arrival, so that the workers evaluate them
+ * concurrently.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sso.h"
+#include "sso_sim.h"
+
+#include "mpi.h"
+
+extern char **environ;
+
+/* Pool used by sim_obj_func() and sim_obj_func_batch() */
+static struct sim_pool_s *active_pool;
+
+/*
+ * This function reads exactly len bytes from a file descriptor.
+ *
+ * Return value
+ * It returns -1 on error or end of file.
+ * It returns 1 on success.
+ */
+static int read_full(int fd, void *buf, size_t len)
+{
+    char *p = (char *)buf;
+    ssize_t r;
+
+    while (len > 0) {
+        r = read(fd, p, len);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+
+    return 1;
+}
+
+/*
+ * This function writes exactly len bytes to a file descriptor.
+ *
+ * Return value
+ * It returns -1 on error.
+ * It returns 1 on success.
+ */
+static int write_full(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    ssize_t r;
+
+    while (len > 0) {
+        r = write(fd, p, len);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+
+    return 1;
+}
+
+/* Print an error about worker w and abort the run (workers failures cannot
+ * be recovered from in the middle of an iteration) */
+static void sim_fail(const struct sim_pool_s *pool, int w, const char *what)
+{
+    printf("simulator worker %d (%s): %s\n", w, pool->cmd, what);
+    fflush(stdout);
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+/*
+ * This function starts a worker running "sh -c cmd", with its standard input
+ * and output connected to pipes, and waits for its hello frame.
+ *
+ * Return value
+ * It returns -1 if the worker could not be started.
+ * It returns -2 if the hello frame is missing or does not match this build.
+ * It returns 1 on success.
+ */
+static int start_worker(struct sim_worker_s *w, const char *cmd)
+{
+    char *argv[] = {"sh", "-c", (char *)cmd, NULL};
+    posix_spawn_file_actions_t fa;
+    struct sso_sim_frame_s hello;
+    int req[2], resp[2]; /* request and response pipes */
+    int status;
+
+    if (pipe(req) == -1) {
+        return -1;
+    }
+    if (pipe(resp) == -1) {
+        close(req[0]);
+        close(req[1]);
+        return -1;
+    }
+
+    /* Our ends must not be inherited by the workers started later, or they
+     * would never see the end of file of their requests */
+    fcntl(req[1], F_SETFD, FD_CLOEXEC);
+    fcntl(resp[0], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_adddup2(&fa, req[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&fa, resp[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&fa, req[0]);
+    posix_spawn_file_actions_addclose(&fa, resp[1]);
+    status = posix_spawn(&w->pid, "/bin/sh", &fa, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+
+    close(req[0]);
+    close(resp[1]);
+    w->to = req[1];
+    w->from = resp[0];
+    if (status != 0) {
+        w->pid = -1;
+        return -1;
+    }
+
+    if (read_full(w->from, &hello, sizeof(hello)) == -1 ||
+        hello.magic != SSO_SIM_MAGIC || hello.version != SSO_SIM_VERSION ||
+        hello.num_size != sizeof(num_t) || hello.status != 0) {
+        return -2;
+    }
+
+    return 1;
+}
+
+/*
+ * This function starts a pool of simulator workers.
+ *
+ * Input parameters
+ * - cmd: worker command (run with sh -c)
+ * - n: number of workers
+ * - threads: threads which evaluate the objective function (n >= threads)
+ * - nd: number of decision variables
+ * - goal: MIN_GOAL / MAX_GOAL
+ *
+ * Output parameters
+ * - pool: worker pool (to stop with sim_stop() in any case)
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred or a worker could
+ * not be started.
+ * It returns -2 if a worker did not answer with a valid hello frame (wrong
+ * command, or worker built for another precision).
+ * It returns 1 on success.
+ */
+int sim_start(struct sim_pool_s *pool, const char *cmd, int n, int threads,
+              int nd, int goal)
+{
+    int i, status;
+
+    pool->cmd = cmd;
+    pool->nd = nd;
+    pool->goal = goal;
+    pool->threads = threads;
+    pool->n = 0;
+    pool->pfd = (struct pollfd *)malloc(n * sizeof(struct pollfd));
+    pool->worker = (struct sim_worker_s *)malloc(n * sizeof(*pool->worker));
+    if (pool->pfd == NULL || pool->worker == NULL) {
+        return -1;
+    }
+
+    /* Writing to a worker which exited must fail instead of killing us */
+    signal(SIGPIPE, SIG_IGN);
+
+    for (i = 0; i < n; i++) {
+        pool->worker[i].pid = -1;
+        pool->worker[i].to = -1;
+        pool->worker[i].from = -1;
+        pool->worker[i].buf = NULL;
+        pool->worker[i].cap = 0;
+        pool->worker[i].pending = 0;
+        pool->n++;
+        status = start_worker(&pool->worker[i], cmd);
+        if (status != 1) {
+            return status;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * This function stops the workers of a pool (closing their standard input)
+ * and waits for them to exit.
+ *
+ * Input parameters
+ * - pool: worker pool
+ */
+void sim_stop(struct sim_pool_s *pool)
+{
+    int i;
+
+    for (i = 0; i < pool->n; i++) {
+        close(pool->worker[i].to);
+    }
+    for (i = 0; i < pool->n; i++) {
+        if (pool->worker[i].pid > 0) {
+            waitpid(pool->worker[i].pid, NULL, 0);
+        }
+        close(pool->worker[i].from);
+        free(pool->worker[i].buf);
+    }
+
+    free(pool->worker);
+    free(pool->pfd);
+    pool->worker = NULL;
+    pool->pfd = NULL;
+    pool->n = 0;
+}
+
+/*
+ * This function sets the pool used by sim_obj_func() and
+ * sim_obj_func_batch(), which have the objective function signature.
+ *
+ * Input parameters
+ * - pool: worker pool (NULL: none)
+ */
+void sim_set_active(struct sim_pool_s *pool)
+{
+    active_pool = pool;
+}
+
+/*
+ * This function evaluates n points with the workers of the calling thread.
+ * Any worker failure aborts the run.
+ *
+ * Input parameters
+ * - pool: worker pool
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+static void sim_eval(struct sim_pool_s *pool, num_t *X, int n, int ld,
+                     num_t *result)
+{
+    struct sso_sim_frame_s frame;
+    struct sim_worker_s *w;
+    struct pollfd *pfd;
+    int t = thread_num();
+    int lo = (t * pool->n) / pool->threads;            /* first worker */
+    int nw = ((t + 1) * pool->n) / pool->threads - lo; /* workers */
+    int parts = MIN(nw, n);
+    int remaining = parts;
+    int p, i;
+    size_t len;
+
+    pfd = &pool->pfd[lo];
+
+    /* Send one contiguous part of the points to each worker */
+    for (p = 0; p < parts; p++) {
+        w = &pool->worker[lo + p];
+        w->first = (int)(((long long)n * p) / parts);
+        w->pending = (int)(((long long)n * (p + 1)) / parts) - w->first;
+
+        len = (size_t)w->pending * pool->nd;
+        if (len > w->cap) {
+            free(w->buf);
+            w->buf = (num_t *)malloc(len * sizeof(num_t));
+            w->cap = w->buf != NULL ? len : 0;
+            if (w->buf == NULL) {
+                sim_fail(pool, lo + p, "memory allocation error");
+            }
+        }
+        for (i = 0; i < w->pending; i++) {
+            memcpy(&w->buf[(size_t)i * pool->nd],
+                   &X[(size_t)(w->first + i) * ld], pool->nd * sizeof(num_t));
+        }
+
+        frame.magic = SSO_SIM_MAGIC;
+        frame.version = SSO_SIM_VERSION;
+        frame.num_size = sizeof(num_t);
+        frame.status = 0;
+        frame.n = (uint32_t)w->pending;
+        frame.nd = (uint32_t)pool->nd;
+        if (write_full(w->to, &frame, sizeof(frame)) == -1 ||
+            write_full(w->to, w->buf, len * sizeof(num_t)) == -1) {
+            sim_fail(pool, lo + p, strerror(errno));
+        }
+
+        pfd[p].fd = w->from;
+        pfd[p].events = POLLIN;
+    }
+
+    /* Collect the responses as they arrive */
+    while (remaining > 0) {
+        if (poll(pfd, parts, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            sim_fail(pool, lo, strerror(errno));
+        }
+
+        for (p = 0; p < parts; p++) {
+            if (pfd[p].fd < 0 || pfd[p].revents == 0) {
+                continue;
+            }
+            w = &pool->worker[lo + p];
+            if (read_full(w->from, &frame, sizeof(frame)) == -1 ||
+                frame.magic != SSO_SIM_MAGIC) {
+                sim_fail(pool, lo + p, "invalid or missing response");
+            }
+            if (frame.status != 0 || frame.n != (uint32_t)w->pending) {
+                sim_fail(pool, lo + p, "evaluation error");
+            }
+            if (read_full(w->from, &result[w->first],
+                          w->pending * sizeof(num_t)) == -1) {
+                sim_fail(pool, lo + p, "truncated response");
+            }
+
+            /* The solver always maximizes */
+            for (i = 0; i < w->pending; i++) {
+                result[w->first + i] *= pool->goal;
+            }
+
+            w->pending = 0;
+            pfd[p].fd = -1;
+            remaining--;
+        }
+    }
+}
+
+/*
+ * Objective function computed by the workers of the active pool
+ *
+ * Input parameters
+ * - X:  input variables (decision variables) vector
+ * - nd:  number of decision variables
+ *
+ * Return value
+ * Function value at a given point
+ */
+num_t sim_obj_func(num_t *X, int nd)
+{
+    num_t val;
+
+    sim_eval(active_pool, X, 1, nd, &val);
+    return val;
+}
+
+/*
+ * Objective function computed by the workers of the active pool (batched
+ * version)
+ *
+ * Input parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - nd: number of decision variables
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: function values (length: n)
+ */
+void sim_obj_func_batch(num_t *X, int n, int nd, int ld, num_t *result)
+{
+    sim_eval(active_pool, X, n, ld, result);
+}
@@ -0,0 +1,185 @@
+/*
+ * Stand-in simulator: a --sim worker (see sso_sim.h) computing one of the
+ * objective functions of of.c, with an artificial latency per point to
+ * mimic an expensive external simulator.
+ *
+ * Usage: sim/of_sim FUNCTION [LATENCY_US [JITTER]]
+ * FUNCTION: elliptic_paraboloid, goldstein_price, flipped_goldstein_price,
+ * rastrigin, griewangk, schaffer or variable_cost
+ * LATENCY_US: sleep per point (microseconds, default: 0)
+ * JITTER: relative latency variation, uniform in [-JITTER, JITTER]
+ * (default: 0)
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../sso.h"
+#include "../sso_sim.h"
+
+/* objective function struct */
+struct sim_func_s {
+    const char *name;                   /* FUNCTION argument */
+    num_t (*obj_func)(num_t *, int nd); /* function of of.c */
+    int goal;                           /* MIN_GOAL / MAX_GOAL */
+    int nd;                             /* decision variables (0: any) */
+};
+
+static const struct sim_func_s funcs[] = {
+    {"elliptic_paraboloid", elliptic_paraboloid, MIN_GOAL, 2},
+    {"goldstein_price", goldstein_price, MIN_GOAL, 2},
+    {"flipped_goldstein_price", flipped_goldstein_price, MAX_GOAL, 2},
+    {"rastrigin", rastrigin, MIN_GOAL, 0},
+    {"griewangk", griewangk, MIN_GOAL, 0},
+    {"schaffer", schaffer, MIN_GOAL, 2},
+    {"variable_cost", variable_cost, MIN_GOAL, 0}};
+
+/* Read exactly len bytes (-1: error or end of file) */
+static int read_full(int fd, void *buf, size_t len)
+{
+    char *p = (char *)buf;
+    ssize_t r;
+
+    while (len > 0) {
+        r = read(fd, p, len);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+
+    return 1;
+}
+
+/* Write exactly len bytes (-1: error) */
+static int write_full(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    ssize_t r;
+
+    while (len > 0) {
+        r = write(fd, p, len);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+
+    return 1;
+}
+
+/* Sleep for us microseconds */
+static void sleep_us(double us)
+{
+    struct timespec ts;
+
+    if (us <= 0) {
+        return;
+    }
+    ts.tv_sec = (time_t)(us / 1e6);
+    ts.tv_nsec = (long)((us - ts.tv_sec * 1e6) * 1e3);
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const struct sim_func_s *f = NULL;
+    struct sso_sim_frame_s frame;
+    double latency = 0, jitter = 0;
+    unsigned int rng_state;
+    num_t *X = NULL, *vals = NULL;
+    size_t cap = 0, len;
+    size_t i;
+    int p;
+
+    for (i = 0; argc > 1 && i < sizeof(funcs) / sizeof(funcs[0]); i++) {
+        if (strcmp(argv[1], funcs[i].name) == 0) {
+            f = &funcs[i];
+        }
+    }
+    if (f == NULL || argc > 4) {
+        fprintf(stderr, "Usage: %s FUNCTION [LATENCY_US [JITTER]]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 2) {
+        latency = atof(argv[2]);
+    }
+    if (argc > 3) {
+        jitter = atof(argv[3]);
+    }
+    rng_state = (unsigned int)getpid();
+
+    /* Hello */
+    frame.magic = SSO_SIM_MAGIC;
+    frame.version = SSO_SIM_VERSION;
+    frame.num_size = sizeof(sso_sim_num_t);
+    frame.status = 0;
+    frame.n = 0;
+    frame.nd = 0;
+    if (write_full(STDOUT_FILENO, &frame, sizeof(frame)) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    /* One response per request, until the solver closes our input */
+    while (read_full(STDIN_FILENO, &frame, sizeof(frame)) == 1) {
+        if (frame.magic != SSO_SIM_MAGIC ||
+            frame.version != SSO_SIM_VERSION ||
+            frame.num_size != sizeof(sso_sim_num_t)) {
+            fprintf(stderr, "%s: invalid request\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        len = (size_t)frame.n * frame.nd;
+        if (len > cap || frame.n > cap) {
+            cap = MAX(len, frame.n);
+            free(X);
+            free(vals);
+            X = (num_t *)malloc(cap * sizeof(num_t));
+            vals = (num_t *)malloc(cap * sizeof(num_t));
+            if (X == NULL || vals == NULL) {
+                fprintf(stderr, "%s: memory allocation error\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        if (read_full(STDIN_FILENO, X, len * sizeof(num_t)) == -1) {
+            fprintf(stderr, "%s: truncated request\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        /* The functions of of.c return -f(x) for minimization problems */
+        frame.status = f->nd != 0 && frame.nd != (uint32_t)f->nd;
+        for (p = 0; p < (int)frame.n && frame.status == 0; p++) {
+            vals[p] = f->goal * f->obj_func(&X[(size_t)p * frame.nd],
+                                            (int)frame.nd);
+            sleep_us(latency *
+                     (1 + jitter * (2.0 * rand_r(&rng_state) / RAND_MAX - 1)));
+        }
+
+        if (write_full(STDOUT_FILENO, &frame, sizeof(frame)) == -1 ||
+            (frame.status == 0 &&
+             write_full(STDOUT_FILENO, vals, frame.n * sizeof(num_t)) == -1)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    free(X);
+    free(vals);
+
+    return EXIT_SUCCESS;
+}
@@ -9,7 +9,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <dlfcn.h>
 
 #include "mpi.h"
 
@@ -20,9 +22,22 @@ int main(int argc, char *argv[])
     int np;                                  /* population size */
     int np_local;                            /* population size (local) */
     int tc;                                  /* test case to run */
-    struct tc_params_s tc_params[NUM_OF_TC]; /* Test cases parameters array */
-    char *endptr;    /* location of the first invalid char (strtol) */
-    num_t **X_local; /* local solutions matrix (np_local * nd) */
+    struct tc_params_s tc_params[NUM_OF_TC + 3]; /* Test cases parameters
+                                                  * array (plugin, expression,
+                                                  * simulator) */
+    const char *plugin_name = NULL; /* objective function name (plugin) */
+    void *plugin_handle = NULL;     /* plugin shared object */
+    struct expr_prog_s expr_prog = {0}; /* compiled expression */
+    char expr_err[EXPR_ERR_LEN];    /* expression syntax error */
+    struct sim_pool_s sim_pool = {0}; /* simulator workers */
+    const char *kernel_name;        /* solver kernel */
+    struct run_opts_s opts; /* command line options */
+    num_t grad_err;         /* analytic gradient error (local) */
+    num_t max_grad_err;     /* analytic gradient error (all processes) */
+    struct population_s pop = {0}; /* local population (np_local sharks) */
+    struct node_s node;     /* node shared memory (--shared) */
+    int nodes;              /* number of nodes (--shared) */
+    MPI_Comm red_comm;      /* final reduction (MPI_COMM_NULL: none) */
     num_t *best_solution_local; /* local solution vector (length: nd+1) */
     num_t best_val_local;       /* best objective function value (min or max) */
     num_t *best_solution;       /* best solution vector (length: nd+1)*/
@@ -30,70 +45,303 @@ int main(int argc, char *argv[])
     MPI_Op custom_min_op;         /* custom min reduce operation */
     MPI_Op custom_max_op;         /* custom max reduce operation */
     double elapsed_time;          /* elapsed time */
-
-    MPI_Init(&argc, &argv);
+    double compute_time;          /* time spent before the final reduction */
+    int thread_support;           /* MPI thread support level */
+    struct run_stats_s stats;     /* run statistics (local) */
+    double ex_latency = 0;        /* blocking exchange latency (reference) */
+    struct node_stats_s fin;      /* final statistics (local or node) */
+    struct node_stats_s tot;      /* final statistics (all processes,
+                                   * process 0) */
+    double reduce_time;           /* final reduction time (process 0, best
+                                   * solution and statistics) */
+    struct topk_s topk;           /* top-K distinct solutions (--top-k) */
+    double topk_time = 0;         /* top-K reduction time (process 0) */
+    FILE *topk_file;              /* --top-k-out */
+    num_t *row;                   /* top-K list row */
+    int first_iter = 0;           /* iterations completed before this run */
+    PROF_VAR(prof_t);             /* start of the profiled phase */
+    int status;                   /* compute_best_solution/run_dynamic */
+    int i, j;
+
+
+    /* Only the main thread makes MPI calls */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
 
     MPI_Comm_rank(MPI_COMM_WORLD, &rank); /* Get my rank */
     MPI_Comm_size(MPI_COMM_WORLD, &size); /* Get number of processes */
 
-    /* Check the number of arguments passed */
-    if (argc != 3) {
-        if (rank == 0) {
-            print_usage(argv[0]);
-        }
+    /* Parse the command line */
+    if (parse_options(argc, argv, rank, &opts) == -1) {
         MPI_Finalize();
         exit(EXIT_FAILURE);
     }
-
-    /* Set population size (check strtol errors) */
-    errno = 0;
-    np = (int)strtol(argv[1], &endptr, 10);
-    if (errno != 0 || endptr == argv[1]) {
+    np = opts.np;
+    tc = opts.tc;
+
+    /* Check if there are too many processes (static distribution only, the
+     * jobs of a parameter sweep are checked by run_sweep; with the decision
+     * variables decomposition, groups of processes share the sharks) */
+    if (opts.dynamic == 0 && opts.sweep == NULL &&
+        size / opts.decompose > np) {
         if (rank == 0) {
-            printf("%s: error: invalid NP parameter\n", argv[0]);
+            printf("%s: error: too many processes\n", argv[0]);
         }
         MPI_Finalize();
         exit(EXIT_FAILURE);
     }
 
-    /* Set test case (check strtol errors) */
-    errno = 0;
-    tc = (int)strtol(argv[2], &endptr, 10);
-    if (errno != 0 || endptr == argv[2]) {
+    /* Set the number of threads per process */
+    if (opts.threads > 0) {
+        set_num_threads(opts.threads);
+    }
+
+    /* The master thread of the parallel regions makes MPI calls: without
+     * MPI_THREAD_FUNNELED support only one thread can be used */
+    if (thread_support < MPI_THREAD_FUNNELED) {
+        if (rank == 0 && max_threads() > 1) {
+            printf("%s: warning: the MPI library does not support "
+                   "MPI_THREAD_FUNNELED, using 1 thread per process\n",
+                   argv[0]);
+        }
+        set_num_threads(1);
+    }
+
+    /* Initialize test case parameters array */
+    init_tc_params(tc_params);
+
+    /* Load the objective function plugin (every process resolves it once) */
+    if (opts.plugin != NULL) {
+        status = plugin_load(opts.plugin, &tc_params[TC_PLUGIN], &plugin_name,
+                             &plugin_handle);
+        if (status == -1) {
+            printf("(%d): cannot load plugin: %s\n", rank, dlerror());
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        } else if (status == -2) {
+            printf("(%d): invalid plugin descriptor in %s\n", rank,
+                   opts.plugin);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+
+    /* Compile the objective function expression on process 0 and send the
+     * program to the others */
+    if (opts.expr != NULL) {
         if (rank == 0) {
-            printf("%s: error: invalid TC parameter\n", argv[0]);
+            status = expr_compile(opts.expr, opts.nd, opts.goal, &expr_prog,
+                                  expr_err, sizeof(expr_err));
+        }
+        MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (status == -2) {
+            if (rank == 0) {
+                printf("%s: error: %s in expression\n", argv[0], expr_err);
+            }
+            MPI_Finalize();
+            exit(EXIT_FAILURE);
+        }
+        if (status == -1 || expr_bcast(&expr_prog, 0, MPI_COMM_WORLD) == -1) {
+            printf("(%d): memory allocation error in expression\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        expr_set_active(&expr_prog);
+        init_func_tc_params(&tc_params[TC_EXPR], expr_obj_func,
+                            expr_obj_func_batch, opts.nd, opts.low, opts.high,
+                            opts.goal);
+    }
+
+    /* Start the simulator workers of this process (each thread needs at
+     * least one) */
+    if (opts.sim != NULL) {
+        if (opts.sim_workers < max_threads()) {
+            if (rank == 0) {
+                printf("%s: error: fewer simulator workers than threads\n",
+                       argv[0]);
+            }
+            MPI_Finalize();
+            exit(EXIT_FAILURE);
+        }
+        status = sim_start(&sim_pool, opts.sim, opts.sim_workers,
+                           max_threads(), opts.nd, opts.goal);
+        if (status == -1) {
+            printf("(%d): cannot start simulator workers\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        } else if (status == -2) {
+            printf("(%d): invalid hello frame from simulator %s\n", rank,
+                   opts.sim);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        sim_set_active(&sim_pool);
+        init_func_tc_params(&tc_params[TC_SIM], sim_obj_func,
+                            sim_obj_func_batch, opts.nd, opts.low, opts.high,
+                            opts.goal);
+    }
+
+    /* Set the seed for the pseudo-random number generator (process 0 chooses
+     * it if not given, so that every process uses the same one) */
+    if (!opts.seed_set) {
+        opts.seed = (uint64_t)time(NULL);
+        MPI_Bcast(&opts.seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    }
+
+    /* Parameter sweep: run every job, then exit (the gradient estimator is
+     * set for every test case; the analytic gradient is kept where no other
+     * estimator exists) */
+    if (opts.sweep != NULL) {
+        for (i = 0; i < NUM_OF_TC; i++) {
+            gradient_configure(&tc_params[i], opts.grad_est, opts.grad_step,
+                               opts.spsa_draws);
+        }
+        status = run_sweep(tc_params, &opts, MPI_COMM_WORLD);
+        if (status == -1) {
+            printf("(%d): memory allocation error in run_sweep\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
         }
         MPI_Finalize();
-        exit(EXIT_FAILURE);
+        exit(status == 1 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    /* Set the number of decision variables of the test case */
+    if (opts.nd_set && opts.plugin == NULL && opts.expr == NULL &&
+        opts.sim == NULL) {
+        if (!tc_params[tc].any_nd) {
+            if (rank == 0) {
+                printf("%s: error: --nd cannot be used with test case %d\n",
+                       argv[0], tc);
+            }
+            MPI_Finalize();
+            exit(EXIT_FAILURE);
+        }
+        tc_params[tc].nd = opts.nd;
     }
-    if (tc < 0 || tc >= NUM_OF_TC) {
+
+    /* Set the gradient estimator */
+    if (gradient_configure(&tc_params[tc], opts.grad_est, opts.grad_step,
+                           opts.spsa_draws) == -1) {
         if (rank == 0) {
-            printf("%s: error: the selected test case does not exist\n",
-                   argv[0]);
+            printf("%s: error: the objective function has no analytic "
+                   "gradient\n", argv[0]);
         }
         MPI_Finalize();
         exit(EXIT_FAILURE);
     }
 
-    /* Check if there are too many processes */
-    if (size > np) {
+    /* Check the decision variables decomposition */
+    if (opts.decompose > 1) {
+        status = 1;
+        if (tc_params[tc].decomp == NULL) {
+            if (rank == 0) {
+                printf("%s: error: the objective function of test case %d "
+                       "cannot be decomposed\n", argv[0], tc);
+            }
+            status = -1;
+        } else if (size % opts.decompose != 0) {
+            if (rank == 0) {
+                printf("%s: error: the number of processes is not a multiple "
+                       "of %d\n", argv[0], opts.decompose);
+            }
+            status = -1;
+        } else if (opts.decompose > tc_params[tc].nd) {
+            if (rank == 0) {
+                printf("%s: error: more processes per group than decision "
+                       "variables\n", argv[0]);
+            }
+            status = -1;
+        }
+        if (status == -1) {
+            MPI_Finalize();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Choose the best solution reduction algorithm */
+    if (opts.reduce == REDUCE_AUTO) {
+        opts.reduce = tc_params[tc].nd >= REDUCE_LOC_MIN_ND ? REDUCE_LOC
+                                                            : REDUCE_OP;
+    }
+
+    /* Verify the analytic gradient (if any) */
+    if (opts.check_grad && tc_params[tc].grad_func != NULL) {
+        if (check_gradient(&tc_params[tc], opts.seed, rank * GRAD_CHECK_POINTS,
+                           GRAD_CHECK_POINTS, &grad_err) == -1) {
+            printf("(%d): memory allocation error in check_gradient\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        MPI_Allreduce(&grad_err, &max_grad_err, 1, NUM_DT, MPI_MAX,
+                      MPI_COMM_WORLD);
+
         if (rank == 0) {
-            printf("%s: error: too many processes\n", argv[0]);
+            printf("Analytic gradient check: max error %e (%d points)%s\n",
+                   max_grad_err, GRAD_CHECK_POINTS * size,
+                   max_grad_err > GRAD_CHECK_TOL
+                       ? ", using finite differences"
+                       : "");
+        }
+        if (max_grad_err > GRAD_CHECK_TOL) {
+            tc_params[tc].grad_func = NULL;
+            tc_params[tc].grad_est = GRAD_CENTRAL;
         }
-        MPI_Finalize();
-        exit(EXIT_FAILURE);
     }
 
-    /* Initialize test case parameters array */
-    init_tc_params(tc_params);
+    /* How many rows (solution vectors) each process should handle */
+    np_local = (((rank + 1) * np) / size) - ((rank * np) / size);
+    // printf("(%d): handling %d rows\n", rank, np_local);
 
-    /* Set the seed for the pseudo-random number generator */
-    srand((unsigned int)time(NULL) + rank);
+    /* Node shared memory: the population arena of this process is part of
+     * the window, and only the node leaders take part in the global best
+     * exchanges and in the final reduction */
+    red_comm = MPI_COMM_WORLD;
+    if (opts.shared) {
+        pop.flags = POP_SHARED;
+        pop.arena_size = population_size(np_local, tc_params[tc].nd,
+                                         POP_SHARED | opts.pop_flags);
+        pop.node = &node;
+        if (node_init(&node, MPI_COMM_WORLD, tc_params[tc].nd,
+                      pop.arena_size, &pop.arena) == -1) {
+            printf("(%d): cannot allocate the node shared window\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        red_comm = node.leaders;
+        if (rank == 0) {
+            MPI_Comm_size(node.leaders, &nodes);
+        }
+    }
 
     /* Process 0: print information */
     if (rank == 0) {
         printf("NP (population size): %d\n", np);
-        printf("TC (test case): %d\n", tc);
+        if (opts.plugin != NULL) {
+            printf("Objective function: %s (%s)\n", plugin_name, opts.plugin);
+        } else if (opts.expr != NULL) {
+            printf("Objective function: %s (%d instructions)\n", opts.expr,
+                   expr_prog.n);
+        } else if (opts.sim != NULL) {
+            printf("Objective function: simulator %s (%d workers per "
+                   "process)\n", opts.sim, opts.sim_workers);
+        } else {
+            printf("TC (test case): %d\n", tc);
+        }
+        printf("Processes: %d, threads per process: %d\n", size,
+               max_threads());
+        if (opts.decompose > 1) {
+            printf("Decision variables decomposition: %d groups of %d "
+                   "processes\n", size / opts.decompose, opts.decompose);
+        }
+        if (opts.shared) {
+            printf("Node shared memory: %d nodes (%d processes on the first "
+                   "one)\n", nodes, node.size);
+        }
+        printf("Seed: %llu\n", (unsigned long long)opts.seed);
+        select_kernel(&tc_params[tc], opts.generic || opts.cache > 0,
+                      &kernel_name);
+        printf("Solver kernel: %s\n", kernel_name);
+        printf("Gradient: %s", gradient_name(tc_params[tc].grad_est));
+        if (tc_params[tc].grad_est == GRAD_SPSA) {
+            printf(" (%d draws, step %g / (k + 1)^%g)", tc_params[tc].spsa_draws,
+                   tc_params[tc].grad_step, SPSA_GAMMA);
+        } else if (tc_params[tc].grad_est != GRAD_ANALYTIC) {
+            printf(" (step %g)", tc_params[tc].grad_step);
+        }
+        printf("\n");
+        printf("Precision: %s\n", PRECISION);
         printf("Goal: %s\n", tc_params[tc].goal == MIN_GOAL ? "minimization"
                                                             : "maximization");
         printf("nd (number of decision variables): %d\n", tc_params[tc].nd);
@@ -111,13 +359,14 @@ int main(int argc, char *argv[])
     MPI_Op_create((MPI_User_function *)&find_min_val, 1, &custom_min_op);
     MPI_Op_create((MPI_User_function *)&find_max_val, 1, &custom_max_op);
 
-    /* How many rows (solution vectors) each process should handle */
-    np_local = (((rank + 1) * np) / size) - ((rank * np) / size);
-    // printf("(%d): handling %d rows\n", rank, np_local);
-
-    /* Allocate space for local solution vectors (matrix) */
-    if (allocate_2d_matrix(&X_local, np_local, tc_params[tc].nd) == -1) {
-        printf("(%d): matrix allocation error (X_local)\n", rank);
+    /* Allocate space for the local population (dynamic distribution: one
+     * chunk at a time, allocated by run_dynamic; decision variables
+     * decomposition: allocated by run_decomposed) */
+    if (opts.dynamic == 0 && opts.decompose == 1 &&
+        population_alloc(&pop, np_local, tc_params[tc].nd,
+                         opts.shared ? POP_SHARED | opts.pop_flags
+                                     : opts.pop_flags) == -1) {
+        printf("(%d): population allocation error\n", rank);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
 
@@ -130,30 +379,86 @@ int main(int argc, char *argv[])
     }
 
     /* Allocate space for best solution vector (only significant at root) */
-    best_solution = (num_t *)malloc((tc_params[tc].nd + 1) * sizeof(num_t));
+    best_solution = (num_t *)calloc(tc_params[tc].nd + 1, sizeof(num_t));
     if (best_solution == NULL) {
         printf("(%d): vector allocation error (best_solution)\n", rank);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
 
+    /* Measure the latency of a blocking exchange, used as a reference for the
+     * latency hidden by the non-blocking one */
+    if (opts.exchange > 0) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        ex_latency = -MPI_Wtime();
+        for (i = 0; i < EXCHANGE_CALIBRATION; i++) {
+            if (opts.reduce == REDUCE_LOC) {
+                allreduce_best(best_solution, best_solution, tc_params[tc].nd,
+                               MAX_GOAL, MPI_COMM_WORLD);
+            } else {
+                MPI_Allreduce(MPI_IN_PLACE, best_solution, 1, row_result_type,
+                              custom_max_op, MPI_COMM_WORLD);
+            }
+        }
+        ex_latency = (ex_latency + MPI_Wtime()) / EXCHANGE_CALIBRATION;
+    }
+
+    /* Resume from a checkpoint (this process reads the sharks whose global
+     * indices start from (rank * np) / size) */
+    if (opts.restart != NULL) {
+        pop.offset = (rank * np) / size;
+        status = checkpoint_read(opts.restart, MPI_COMM_WORLD, np, tc, &pop);
+        if (status < 0) {
+            if (rank == 0) {
+                printf("%s: error: %s %s\n", argv[0],
+                       status == -2 ? "NP or TC do not match checkpoint"
+                                    : "cannot read checkpoint",
+                       opts.restart);
+            }
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        first_iter = pop.iter;
+        if (rank == 0) {
+            printf("Resuming from %s: %d iterations completed, seed %llu\n\n",
+                   opts.restart, pop.iter, (unsigned long long)pop.seed);
+        }
+    }
+
     /* Start the timer */
     MPI_Barrier(MPI_COMM_WORLD);
     elapsed_time = -MPI_Wtime();
 
-    /* Initialize local solution vectors */
-    init_positions(X_local, np_local, tc_params[tc].nd, tc_params[tc].low,
-                   tc_params[tc].high);
+    if (opts.dynamic > 0) {
+        /* Compute best solution (chunks handed out on demand) */
+        status = run_dynamic(tc_params[tc], &opts, np, MPI_COMM_WORLD,
+                             best_solution_local, &best_val_local, &stats);
+    } else if (opts.decompose > 1) {
+        /* Compute best solution (decision variables split among the processes
+         * of each group) */
+        status = run_decomposed(tc_params[tc], &opts, np, MPI_COMM_WORLD,
+                                best_solution_local, &best_val_local, &stats);
+    } else {
+        /* Initialize local solution vectors (this process handles the sharks
+         * whose global indices start from (rank * np) / size) */
+        if (opts.restart == NULL) {
+            pop.offset = (rank * np) / size;
+            pop.seed = opts.seed;
+            init_positions(&pop, tc_params[tc].low, tc_params[tc].high);
+        }
 
-    /* Print initial solution matrix (each process) */
-    // print_matrix(rank, X_local, np_local, tc_params[tc].nd);
+        /* Print initial solution matrix (each process) */
+        // print_matrix(rank, pop.X, np_local, tc_params[tc].nd);
 
-    /* Compute best solution */
-    if (compute_best_solution(tc_params[tc], X_local, np_local,
-                              best_solution_local, &best_val_local) == -1) {
-        printf("(%d): memory allocation error in compute_best_solution\n",
-               rank);
+        /* Compute best solution */
+        status = compute_best_solution(tc_params[tc], &pop, &opts,
+                                       MPI_COMM_WORLD, best_solution_local,
+                                       &best_val_local, &stats);
+    }
+    if (status == -1) {
+        printf("(%d): memory allocation or checkpoint error in "
+               "compute_best_solution\n", rank);
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    compute_time = elapsed_time + MPI_Wtime();
 
     /* Put best_val_local in the last vector position */
     best_solution_local[tc_params[tc].nd] = best_val_local;
@@ -161,18 +466,79 @@ int main(int argc, char *argv[])
     /* Print best solution and best objective function value (each process) */
     // print_vector(rank, best_solution_local, tc_params[tc].nd + 1);
 
-    /* Use MPI_Reduce to get the solution vector and the best OF value */
-    if (tc_params[tc].goal == MIN_GOAL) {
-        MPI_Reduce(best_solution_local, best_solution, 1, row_result_type,
-                   custom_min_op, 0, MPI_COMM_WORLD);
-    } else {
-        MPI_Reduce(best_solution_local, best_solution, 1, row_result_type,
-                   custom_max_op, 0, MPI_COMM_WORLD);
+    /* Final statistics of this process */
+    fin.time_min = compute_time;
+    fin.time_max = compute_time;
+    fin.time_sum = compute_time;
+    fin.exchange_wait = stats.exchange_wait;
+    fin.evals = stats.evals;
+    fin.lookups = stats.lookups;
+    fin.cache_hits = stats.cache_hits;
+    fin.reused = stats.reused;
+    fin.rss_max = peak_rss();
+    fin.rss_sum = fin.rss_max;
+    fin.target_iter = stats.target_iter < 0 ? INT_MAX : stats.target_iter;
+    fin.iterations = stats.iterations;
+    fin.stop_reason = stats.stop_reason;
+
+    PROF_START(prof_t);
+    reduce_time = -MPI_Wtime();
+
+    /* Combine the results of the processes of each node at its leader */
+    if (opts.shared) {
+        node_reduce(&node, tc_params[tc].goal, best_solution_local, &fin);
     }
 
+    /* Reduce the (value, rank) pairs and get the vector from its owner, or use
+     * MPI_Reduce with a custom operation on the whole vector (--shared: node
+     * leaders only) */
+    if (red_comm != MPI_COMM_NULL) {
+        if (opts.reduce == REDUCE_LOC) {
+            reduce_best(best_solution_local, best_solution, tc_params[tc].nd,
+                        tc_params[tc].goal, 0, red_comm);
+        } else if (tc_params[tc].goal == MIN_GOAL) {
+            MPI_Reduce(best_solution_local, best_solution, 1, row_result_type,
+                       custom_min_op, 0, red_comm);
+        } else {
+            MPI_Reduce(best_solution_local, best_solution, 1, row_result_type,
+                       custom_max_op, 0, red_comm);
+        }
+    }
+
+    PROF_LAP(stats.prof, PROF_REDUCE, prof_t, 0);
+    reduce_time += MPI_Wtime();
+
     /* Stop the timer (get the total elapsed time) */
     MPI_Barrier(MPI_COMM_WORLD);
     elapsed_time += MPI_Wtime();
+    PROF_LAP(stats.prof, PROF_BARRIER, prof_t, 0);
+
+    /* Collect statistics (a single reduction): iterations needed by the first
+     * process reaching the target, longest time blocked in exchanges, totals */
+    if (red_comm != MPI_COMM_NULL) {
+        reduce_time -= MPI_Wtime();
+        node_stats_reduce(&fin, &tot, red_comm);
+        reduce_time += MPI_Wtime();
+    }
+
+    /* Merge the top-K lists of the local populations (K (nd + 1) values per
+     * message, whatever NP) */
+    if (opts.top_k > 0) {
+        if (topk_init(&topk, opts.top_k, tc_params[tc].nd,
+                      opts.top_k_dist >= 0
+                          ? opts.top_k_dist
+                          : TOPK_DIST_REL *
+                                (tc_params[tc].high - tc_params[tc].low)) ==
+                -1 ||
+            topk_select(&topk, pop.X, pop.best_OF_vals, np_local) == -1) {
+            printf("(%d): memory allocation error in the top-K reduction\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        topk_time = -MPI_Wtime();
+        MPI_Reduce(topk.local, topk.result, 1, topk.type, topk.op, 0,
+                   MPI_COMM_WORLD);
+        topk_time += MPI_Wtime();
+    }
 
     /* Process 0: print result vector, OF value and total elapsed time */
     if (rank == 0) {
@@ -181,9 +547,125 @@ int main(int argc, char *argv[])
         printf("Best objective function value: %f\n",
                best_solution[tc_params[tc].nd]);
         printf("Total elapsed time (seconds): %8.6f\n", elapsed_time);
+        printf("Time before final reduction (seconds): min %8.6f, mean "
+               "%8.6f, max %8.6f\n",
+               tot.time_min, tot.time_sum / size, tot.time_max);
+        printf("Objective function evaluations: %lld (%.4e per second)\n",
+               tot.evals, tot.evals / elapsed_time);
+        printf("Peak resident set size (MiB): max %.1f, total %.1f\n",
+               tot.rss_max / 1024.0, tot.rss_sum / 1024.0);
+        printf("Final reduction (seconds, process 0): %8.6f\n", reduce_time);
+        printf("Evaluations avoided: %lld with the known f(X)", tot.reused);
+        if (opts.cache > 0) {
+            printf(", %lld cache hits (%.2f%% of %lld lookups)",
+                   tot.cache_hits, 100.0 * tot.cache_hits / MAX(tot.lookups, 1),
+                   tot.lookups);
+        }
+        printf("\n");
+        if (opts.exchange > 0 && stats.exchanges > 0) {
+            printf("Global best exchanges: %d (every %d iterations), blocked "
+                   "%8.6f s, latency hidden: %5.1f%%\n",
+                   stats.exchanges, opts.exchange, tot.exchange_wait,
+                   100.0 * MAX(0.0, 1.0 - tot.exchange_wait /
+                                              stats.exchanges / ex_latency));
+        }
+        if (tot.stop_reason != STOP_NONE) {
+            /* Time saved estimated from the mean time per iteration */
+            printf("Stopped early (%s): %d of %d iterations, estimated time "
+                   "saved %8.6f s\n",
+                   tot.stop_reason == STOP_TARGET ? "target reached"
+                                                  : "stagnation",
+                   tot.iterations, tc_params[tc].k_max,
+                   tot.time_sum / size / MAX(tot.iterations - first_iter, 1) *
+                       (tc_params[tc].k_max - tot.iterations));
+        }
+        if (opts.checkpoint != NULL) {
+            printf("Checkpoints: %d written to %s, blocked %8.6f s\n",
+                   stats.checkpoints, opts.checkpoint, stats.checkpoint_wait);
+        }
+        if (opts.target_set) {
+            if (tot.target_iter == INT_MAX) {
+                printf("Target %f not reached in %d iterations\n",
+                       opts.target, tot.iterations);
+            } else {
+                printf("Iterations to target %f: %d\n", opts.target,
+                       tot.target_iter);
+            }
+        }
+        if (opts.csv) {
+            printf("csv,%d,%d,%d,%d,%.6f,%lld,%.6e,%.9e,%d\n", tc, np, size,
+                   max_threads(), elapsed_time, tot.evals,
+                   tot.evals / elapsed_time,
+                   best_solution[tc_params[tc].nd], tot.iterations);
+        }
         fflush(stdout);
     }
 
+    /* Process 0: print or save the top-K distinct solutions (reported
+     * values) */
+    if (opts.top_k > 0) {
+        if (rank == 0) {
+            topk_file = stdout;
+            if (opts.top_k_out != NULL) {
+                topk_file = fopen(opts.top_k_out, "w");
+                if (topk_file == NULL) {
+                    printf("(%d): cannot write the solutions to %s\n", rank,
+                           opts.top_k_out);
+                } else {
+                    fprintf(topk_file, "rank,value");
+                    for (i = 0; i < tc_params[tc].nd; i++) {
+                        fprintf(topk_file, ",x%d", i);
+                    }
+                    fprintf(topk_file, "\n");
+                }
+            } else {
+                printf("Top %d distinct solutions (minimum distance %g, "
+                       "reduction %8.6f s):\n",
+                       topk.k, (double)topk.dist, topk_time);
+            }
+
+            for (i = 0; topk_file != NULL && i < topk.k; i++) {
+                row = &topk.result[(size_t)i * (tc_params[tc].nd + 1)];
+                if (row[tc_params[tc].nd] == -INFINITY) {
+                    break;
+                }
+                if (topk_file == stdout) {
+                    printf("%3d: %f  ", i + 1,
+                           tc_params[tc].goal * row[tc_params[tc].nd]);
+                    print_vector(0, row, tc_params[tc].nd);
+                } else {
+                    fprintf(topk_file, "%d,%.9e", i + 1,
+                            tc_params[tc].goal * row[tc_params[tc].nd]);
+                    for (j = 0; j < tc_params[tc].nd; j++) {
+                        fprintf(topk_file, ",%.9e", row[j]);
+                    }
+                    fprintf(topk_file, "\n");
+                }
+            }
+
+            if (topk_file != NULL && topk_file != stdout) {
+                fclose(topk_file);
+                printf("Top %d distinct solutions: %d saved to %s "
+                       "(reduction %8.6f s)\n",
+                       topk.k, i, opts.top_k_out, topk_time);
+            }
+            fflush(stdout);
+        }
+        topk_free(&topk);
+    }
+
+#ifdef SSO_PROFILE
+    /* Per-phase profile (min/mean/max over the processes) */
+    if (prof_report(&stats.prof, MPI_COMM_WORLD, opts.prof_json) == -1) {
+        printf("(%d): cannot write profile to %s\n", rank, opts.prof_json);
+    }
+#else
+    if (rank == 0 && opts.prof_json != NULL) {
+        printf("%s: warning: profiling is disabled (build with "
+               "PROFFLAGS=-DSSO_PROFILE)\n", argv[0]);
+    }
+#endif
+
     /* Free datatype */
     MPI_Type_free(&row_result_type);
 
@@ -193,27 +675,19 @@ int main(int argc, char *argv[])
 
     /* Free heap space */
     free(best_solution_local);
-    free_2d_matrix(&X_local, np_local);
+    population_free(&pop);
+    if (opts.shared) {
+        node_free(&node);
+    }
     free(best_solution);
+    if (plugin_handle != NULL) {
+        plugin_close(plugin_handle);
+    }
+    expr_free(&expr_prog);
+    if (opts.sim != NULL) {
+        sim_stop(&sim_pool);
+    }
 
     MPI_Finalize();
     return 0;
 }
-
-/* Print usage information */
-void print_usage(char *name)
-{
-    printf("Usage: %s NP TC\n", name);
-    printf("NP: population size\n");
-    printf("TC: test case\n\n");
-    printf("TC is a number which can assume the following values:\n");
-    printf("0) Elliptic Paraboloid\n");
-    printf("1) Goldstein-Price function\n");
-    printf("2) \"Flipped\" Goldstein-Price function\n");
-    printf("3) Rastrigin function (two decision variables)\n");
-    printf("4) Rastrigin function (five decision variables)\n");
-    printf("5) Griewangk function (two decision variables)\n");
-    printf("6) Griewangk function (five decision variables)\n");
-    printf("7) Schaffer function\n\n");
-    fflush(stdout);
-}
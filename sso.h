@@ -6,27 +6,234 @@
 #ifndef SSO_H
 #define SSO_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "mpi.h"
 
 /* MAX/MIN macros */
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
+/* Floating point precision, chosen at build time:
+ * - default: double population and double arithmetic in the objective
+ *   functions
+ * - SSO_FLOAT: float population and float arithmetic
+ * - SSO_MIXED: float population, double arithmetic (acc_t) in the objective
+ *   functions and their gradients
+ * num_t is the type of positions, velocities and objective function values
+ * (and of the MPI messages carrying them), acc_t the type of the
+ * intermediate values of the objective functions */
+#if defined(SSO_FLOAT) && defined(SSO_MIXED)
+#error "SSO_FLOAT and SSO_MIXED are mutually exclusive"
+#endif
+
+#if defined(SSO_FLOAT) || defined(SSO_MIXED)
+/* Basic C language type to use */
+typedef float num_t;
+
+/* Basic MPI datatype to use */
+#define NUM_DT MPI_FLOAT
+
+/* MPI datatype of a (num_t, int) pair (MPI_MINLOC / MPI_MAXLOC) */
+#define NUM_INT_DT MPI_FLOAT_INT
+
+/* Differentiation step size (larger than in double precision: with the
+ * double precision step the rounding error of the num_t objective function
+ * values would dominate the central difference) */
+#define D_INCR 0.002
+
+/* Differentiation step size relative to high - low (--grad-step auto: D_INCR
+ * on the [-20, 20] range) */
+#define GRAD_STEP_REL 5e-5
+
+/* Maximum relative error of the analytic gradients (see GRAD_CHECK_POINTS):
+ * the finite differences they are compared with are only accurate to about
+ * 1e-2 in single precision */
+#define GRAD_CHECK_TOL 5e-2
+#else
+/* Basic C language type to use */
+typedef double num_t;
+
 /* Basic MPI datatype to use */
 #define NUM_DT MPI_DOUBLE
 
+/* MPI datatype of a (num_t, int) pair (MPI_MINLOC / MPI_MAXLOC) */
+#define NUM_INT_DT MPI_DOUBLE_INT
+
+/* Differentiation step size */
+#define D_INCR 0.0001
+
+/* Differentiation step size relative to high - low (--grad-step auto: D_INCR
+ * on the [-20, 20] range) */
+#define GRAD_STEP_REL 2.5e-6
+
+/* Maximum relative error of the analytic gradients (see GRAD_CHECK_POINTS) */
+#define GRAD_CHECK_TOL 1e-4
+#endif
+
+#if defined(SSO_FLOAT)
+typedef float acc_t;
+#define PRECISION "float"
+#elif defined(SSO_MIXED)
+typedef double acc_t;
+#define PRECISION "mixed (float, double arithmetic)"
+#else
+typedef double acc_t;
+#define PRECISION "double"
+#endif
+
+/* Best solution reduction algorithms */
+#define REDUCE_AUTO -1 /* REDUCE_LOC if nd >= REDUCE_LOC_MIN_ND */
+#define REDUCE_OP 0    /* custom reduce operation on the whole vector */
+#define REDUCE_LOC 1   /* MPI_MINLOC / MPI_MAXLOC on (value, rank), then send */
+
+/* Smallest nd for which REDUCE_LOC is faster (see bench/bench_reduce) */
+#define REDUCE_LOC_MIN_ND 100
+
+/* Top-K distinct solutions (--top-k): default minimum distance between two
+ * solutions, relative to high - low */
+#define TOPK_DIST_REL 1e-3
+
 /* Number of available test cases */
-#define NUM_OF_TC 8
+#define NUM_OF_TC 9
+
+/* Test case index of the objective function loaded from a plugin */
+#define TC_PLUGIN NUM_OF_TC
+
+/* Test case index of the objective function given by an expression */
+#define TC_EXPR (NUM_OF_TC + 1)
+
+/* Test case index of the objective function computed by simulator workers */
+#define TC_SIM (NUM_OF_TC + 2)
+
+/* Default number of simulator workers per process (see sso_sim.h) */
+#define SIM_WORKERS 4
+
+/* Expression evaluator limits */
+#define EXPR_LANES 32     /* points evaluated together */
+#define EXPR_MAX_REGS 32  /* registers */
+#define EXPR_MAX_LOOPS 4  /* nested sum/prod */
+#define EXPR_NAME_LEN 16  /* identifier length (including '\0') */
+#define EXPR_ERR_LEN 128  /* error message length */
+
+/* Minimum number of dummy operations per evaluation (variable_cost()) */
+#define VC_WORK 2000
 
 /* Minimization or maximization of the objective function */
 #define MIN_GOAL -1
 #define MAX_GOAL 1
 
-/* Differentiation step size */
-#define D_INCR 0.0001
+/* Maximum number of points per batched gradient evaluation */
+#define GRAD_BATCH 64
 
-/* Basic C language type to use */
-typedef double num_t;
+/* Gradient estimators (see grad.c) */
+#define GRAD_ANALYTIC 0 /* grad_func */
+#define GRAD_CENTRAL 1  /* central differences (2 nd evaluations) */
+#define GRAD_FORWARD 2  /* forward differences (nd evaluations, f(X) reused) */
+#define GRAD_SPSA 3     /* simultaneous perturbation (2 evaluations per draw) */
+
+/* Decay exponent of the SPSA perturbation, c / (k + 1)^SPSA_GAMMA */
+#define SPSA_GAMMA 0.101
+
+/* Analytic gradient verification: number of random points (the maximum
+ * relative error allowed, GRAD_CHECK_TOL, depends on the precision) */
+#define GRAD_CHECK_POINTS 100
+
+/* Sharks processed between two progress calls on an active exchange */
+#define EXCHANGE_POLL 64
+
+/* Sharks whose candidates are evaluated by a single reduction (decision
+ * variables decomposition, see decomp.c) */
+#define DECOMP_CHUNK 64
+
+/* Evaluation cache slot states */
+#define CACHE_EMPTY 0   /* no point */
+#define CACHE_VALID 1   /* point and value */
+#define CACHE_PENDING 2 /* point of the batch being evaluated */
+
+/* Exchange states */
+#define EXCHANGE_IDLE 0      /* no exchange in progress */
+#define EXCHANGE_REDUCE 1    /* reduction in flight */
+#define EXCHANGE_BCAST 2     /* broadcast of the winning vector in flight */
+#define EXCHANGE_COMPLETED 3 /* completed, not applied yet */
+#define EXCHANGE_GATHER 4    /* node best rows being published (--shared) */
+#define EXCHANGE_PUBLISH 5   /* global best being published on the node */
+
+/* Blocking reductions used to measure the reference exchange latency */
+#define EXCHANGE_CALIBRATION 10
+
+/* Memory alignment (bytes) for population storage */
+#define CACHE_LINE 64
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+/* PRNG streams (independent sequences for each purpose) */
+#define RNG_STREAM_INIT 0   /* initial positions */
+#define RNG_STREAM_GLOBAL 1 /* R1 and R2 (same for every shark) */
+#define RNG_STREAM_R3 2     /* rotational movement */
+#define RNG_STREAM_SPSA 3   /* SPSA directions */
+#define RNG_STREAM_CHECK 4  /* analytic gradient check points (--check-grad) */
+
+/* Population allocation flags */
+#define POP_SOA 1       /* structure-of-arrays layout (one block per field) */
+#define POP_HUGEPAGES 2 /* hugepage-aligned arena */
+#define POP_SHARED 4    /* arena provided by the caller (node shared window,
+                         * not freed by population_free()) */
+
+/* Checkpoint file: header of CKPT_HEADER_LEN int64 values (CKPT_H_*), then
+ * one record [X (nd), V (nd), best OF value] per shark in global order */
+#define CKPT_MAGIC 0x53534f434b505431LL /* "SSOCKPT1" */
+#define CKPT_H_MAGIC 0
+#define CKPT_H_NUM_SIZE 1 /* sizeof(num_t) */
+#define CKPT_H_NP 2
+#define CKPT_H_ND 3
+#define CKPT_H_TC 4
+#define CKPT_H_ITER 5 /* completed iterations */
+#define CKPT_H_SEED 6
+#define CKPT_HEADER_LEN 7
+
+/* Default checkpoint interval (iterations) */
+#define CKPT_EVERY 10
+
+/* Early termination: reasons and smallest scale of the relative improvement
+ * threshold (absolute below it) */
+#define STOP_NONE 0       /* still running (or k_max reached) */
+#define STOP_STAGNATION 1 /* improvement below threshold over the window */
+#define STOP_TARGET 2     /* target reached */
+#define STOP_MIN_SCALE 1e-8
+
+/* Parameter sweep: default output file and longest job file line */
+#define SWEEP_OUT "sweep.csv"
+#define SWEEP_LINE_LEN 256
+
+/* Profiled phases (build with -DSSO_PROFILE) */
+#define PROF_GRADIENT 0 /* gradient computation */
+#define PROF_UPDATE 1   /* velocity and forward movement */
+#define PROF_ROTATE 2   /* rotational movement positions */
+#define PROF_EVAL 3     /* objective function evaluations */
+#define PROF_SELECT 4   /* best candidate selection */
+#define PROF_EXCHANGE 5 /* global best exchange */
+#define PROF_BARRIER 6  /* thread and process synchronization */
+#define PROF_REDUCE 7   /* final reduction */
+#define PROF_PHASES 8
+
+/* objective function decomposed over the decision variables:
+ * f(x) = F(S, P), S = sum_j s_j(x_j), P = prod_j p_j(x_j), so that each
+ * process of a group computes the partial S and P of its slice of the
+ * decision variables (P = 1 if prod is 0) */
+struct decomp_func_s {
+    void (*partial)(num_t *X, int n, int ld, int j0, int nj,
+                    num_t *sp); /* (S, P) of n slices [j0, j0 + nj) */
+    num_t (*value)(const num_t *sp, int nd); /* F(S, P) */
+    void (*grad)(num_t *X, int j0, int nj, num_t p_other,
+                 num_t *result); /* gradient slice (P outside: p_other) */
+    int prod;                    /* P used */
+};
 
 /* test case parameters struct */
 struct tc_params_s {
@@ -34,20 +241,373 @@ struct tc_params_s {
     num_t low;                           /* decision variables lower bound */
     num_t high;                          /* decision veriables upper bound */
     int goal;                            /* MIN_GOAL / MAX_GOAL */
-    double (*obj_func)(num_t *, int nd); /* objective function */
+    num_t (*obj_func)(num_t *, int nd);  /* objective function */
+    void (*obj_func_batch)(num_t *, int n, int nd, int ld,
+                           num_t *result); /* batched OF (optional) */
+    void (*grad_func)(num_t *, int nd,
+                      num_t *result); /* OF gradient (optional) */
     num_t eta;                           /* eta */
     num_t alpha;                         /* alpha */
     num_t beta;                          /* beta */
     num_t delta_t;                       /* delta_t*/
-    num_t m_points;                      /* M (local search) */
-    num_t k_max;                         /* total steps */
+    int m_points;                        /* M (local search) */
+    int k_max;                           /* total steps */
     num_t initial_velocity;              /* initial velocity */
+    const struct decomp_func_s *decomp;  /* decomposed OF (optional) */
+    int any_nd;                          /* OF defined for any nd (--nd) */
+    int grad_est;                        /* GRAD_* (no grad_func: not
+                                          * GRAD_ANALYTIC) */
+    double grad_step;                    /* finite differences step */
+    int spsa_draws;                      /* directions averaged (SPSA) */
+};
+
+/* (value, rank) pair struct (layout of NUM_INT_DT) */
+struct val_rank_s {
+    num_t val; /* objective function value */
+    int rank;  /* owner rank */
+};
+
+/* population struct: all per-shark state, stored in a single arena */
+struct population_s {
+    int np;              /* population size */
+    int nd;              /* number of decision variables */
+    int ld;              /* row stride (elements) */
+    int flags;           /* POP_* allocation flags */
+    num_t **X;           /* positions (np rows) */
+    num_t **V;           /* velocities (np rows) */
+    num_t *best_OF_vals; /* best objective function values (np) */
+    int offset;          /* global index of the first shark */
+    uint64_t seed;       /* PRNG seed */
+    int iter;            /* completed iterations */
+    void *arena;         /* memory block holding everything above */
+    size_t arena_size;   /* arena size (bytes) */
+    struct node_s *node; /* node shared window holding the arena
+                          * (POP_SHARED, NULL: none) */
+};
+
+/* gradient workspace struct */
+struct grad_ws_s {
+    int nd;         /* number of decision variables */
+    int batch;      /* stencil points per batched evaluation (0: none) */
+    num_t *point;   /* perturbed point (nd) */
+    num_t *stencil; /* stencil points (batch * nd) */
+    num_t *vals;    /* objective function values at stencil points */
+};
+
+/* run options struct (command line) */
+struct run_opts_s {
+    int np;         /* population size */
+    int tc;         /* test case to run */
+    int check_grad; /* verify the analytic gradient before running */
+    int threads;    /* threads per process (0: OpenMP default) */
+    uint64_t seed;  /* PRNG seed */
+    int seed_set;   /* seed given on the command line */
+    int exchange;   /* global best exchange interval (0: never) */
+    num_t target;   /* target objective function value */
+    int target_set; /* target given on the command line */
+    int dynamic;    /* dynamic distribution chunk size (0: static) */
+    int reduce;     /* best solution reduction (REDUCE_*) */
+    int csv;        /* print a machine-readable summary line */
+    char *prof_json; /* profile report file (JSON, NULL: none) */
+    char *checkpoint; /* checkpoint file (NULL: none) */
+    int checkpoint_every; /* checkpoint interval (iterations) */
+    char *restart;  /* checkpoint file to resume from (NULL: none) */
+    int stop_window; /* stagnation window (iterations, 0: never stop) */
+    num_t stop_tol; /* relative improvement threshold over the window */
+    int stop_target; /* stop when the target is reached */
+    char *plugin;   /* objective function plugin (NULL: none) */
+    char *expr;     /* objective function expression (NULL: none) */
+    int nd;         /* decision variables (expression or test case) */
+    int nd_set;     /* nd given on the command line */
+    num_t low;      /* decision variables lower bound (expression) */
+    num_t high;     /* decision variables upper bound (expression) */
+    int goal;       /* MIN_GOAL / MAX_GOAL (expression) */
+    char *sweep;    /* parameter sweep job file (NULL: single run) */
+    char *sweep_out; /* parameter sweep results file */
+    int group_size; /* processes per parameter sweep group */
+    int generic;    /* always use the generic solver kernel */
+    int decompose;  /* processes sharing the decision variables (1: none) */
+    char *sim;      /* simulator worker command (NULL: none) */
+    int cache;      /* evaluation cache slots per thread (0: none) */
+    int grad_est;   /* GRAD_* (-1: test case estimator) */
+    num_t grad_step; /* step as a fraction of high - low (0: test case) */
+    int spsa_draws; /* directions averaged by the SPSA estimator */
+    int shared;     /* populations in node shared memory, results combined
+                     * on each node first */
+    int top_k;      /* distinct solutions reported (0: only the best) */
+    num_t top_k_dist; /* minimum distance between them (< 0: default) */
+    const char *top_k_out; /* CSV file of the solutions (NULL: print) */
+    int pop_flags;  /* population layout (POP_SOA, POP_HUGEPAGES) */
+    int sim_workers; /* simulator workers per process */
+};
+
+/* final statistics struct: values of one process, or combined over the
+ * processes of a node (--shared) */
+struct node_stats_s {
+    double time_min;      /* time before the final reduction (min) */
+    double time_max;      /* time before the final reduction (max) */
+    double time_sum;      /* time before the final reduction (sum) */
+    double exchange_wait; /* time blocked in exchanges (max) */
+    long long evals;      /* objective function evaluations (sum) */
+    long long lookups;    /* evaluation cache lookups (sum) */
+    long long cache_hits; /* evaluation cache hits (sum) */
+    long long reused;     /* evaluations avoided with the known f(X) (sum) */
+    long rss_max;         /* peak resident set size (KiB, max) */
+    long rss_sum;         /* peak resident set size (KiB, sum) */
+    int target_iter;      /* iterations to target (min, INT_MAX: never) */
+    int iterations;       /* iterations completed (max) */
+    int stop_reason;      /* STOP_* (max) */
+};
+
+/* top-K distinct solutions struct: a list is K rows of nd+1 values (decision
+ * variables, then the maximized objective function value), sorted by
+ * decreasing value; unused rows have value -INFINITY */
+struct topk_s {
+    int k;             /* rows per list */
+    int nd;            /* number of decision variables */
+    num_t dist;        /* minimum distance between two rows */
+    MPI_Datatype type; /* one list (attribute: this struct) */
+    MPI_Op op;         /* merge_topk() */
+    num_t *local;      /* list of this process */
+    num_t *result;     /* merged list (root) */
+    num_t *merge;      /* scratch list (merge_topk()) */
+};
+
+/* node shared memory struct (--shared) */
+struct node_s {
+    MPI_Comm comm;              /* processes of this node */
+    MPI_Comm leaders;           /* node leaders (MPI_COMM_NULL elsewhere) */
+    int rank;                   /* rank in comm (0: node leader) */
+    int size;                   /* processes of this node */
+    int nd;                     /* number of decision variables */
+    MPI_Win win;                /* shared window */
+    struct node_stats_s *stats; /* final statistics (size, leader segment) */
+    num_t *best;                /* best solution vectors (size rows of nd+1,
+                                 * leader segment) */
+    num_t *result;              /* global best of the last exchange (nd+1,
+                                 * leader segment) */
+};
+
+/* per-phase profile struct (times and counts are summed over threads) */
+struct prof_s {
+    double time[PROF_PHASES];    /* time spent (s) */
+    long long calls[PROF_PHASES]; /* timed sections */
+    long long evals[PROF_PHASES]; /* objective function evaluations */
+};
+
+/* run statistics struct (one process) */
+struct run_stats_s {
+    int iterations;     /* iterations performed */
+    int stop_reason;    /* STOP_* (early termination) */
+    int target_iter;    /* iterations needed to reach the target (-1: never) */
+    int exchanges;      /* completed global best exchanges */
+    double exchange_wait;   /* time blocked completing exchanges (s) */
+    double exchange_flight; /* time between start and completion (s) */
+    int chunks;         /* chunks processed (dynamic distribution) */
+    long long evals;    /* objective function evaluations */
+    long long lookups;  /* points looked up in the evaluation caches */
+    long long cache_hits; /* evaluations found in the evaluation caches */
+    long long reused;   /* evaluations avoided with the known f(X) */
+    int checkpoints;    /* checkpoints written */
+    double checkpoint_wait; /* time blocked completing checkpoints (s) */
+    struct prof_s prof; /* per-phase profile (SSO_PROFILE builds) */
+};
+
+/* evaluation cache struct (one per thread): values of recently evaluated
+ * points, keyed on their exact bits (direct-mapped hash table) */
+struct eval_cache_s {
+    int nd;                 /* number of decision variables */
+    int slots;              /* slots (power of two, 0: disabled) */
+    int batch;              /* points looked up together */
+    num_t *keys;            /* points (slots rows of nd) */
+    num_t *vals;            /* values (slots) */
+    unsigned char *state;   /* CACHE_* (slots) */
+    int *owner;             /* pending slots: point to evaluate (slots) */
+    num_t *miss;            /* points to evaluate (batch rows of nd) */
+    num_t *miss_vals;       /* their values (batch) */
+    int *miss_slot;         /* their slots (batch) */
+    int *src;               /* value of each point of the batch: point to
+                             * evaluate, -1 if found (batch) */
+    long long lookups;      /* points looked up */
+    long long hits;         /* points found (or repeated in the batch) */
+    long long reused;       /* forward positions equal to X (known f(X)) */
+};
+
+/* per-thread solver kernel workspace struct */
+struct shark_ws_s {
+    num_t *gradient_result; /* gradient (nd) */
+    num_t *cand;            /* forward position, then rotational positions
+                             * (1 + m_points rows, stride ld) */
+    num_t *cand_OF_vals;    /* OF values at the candidates (1 + m_points) */
+    num_t *R3;              /* random numbers (m_points) */
+    struct grad_ws_s grad;  /* gradient workspace */
+    struct eval_cache_s cache; /* evaluation cache and reuse counters */
+    struct prof_s prof;     /* per-phase profile (this thread) */
+    double prof_t;          /* start of the current phase (SSO_PROFILE) */
+};
+
+/* solver kernel: moves shark i of pop at iteration k (see kernel.h) */
+typedef void (*shark_step_t)(const struct tc_params_s *tc_params,
+                             struct population_s *pop, int i, int k,
+                             num_t R1, num_t R2, struct shark_ws_s *ws);
+
+/* Profiling macros: PROF_START(t) stores the current time in t,
+ * PROF_LAP(p, phase, t, n) charges the time elapsed since t and n evaluations
+ * to phase and restarts t. They expand to nothing unless SSO_PROFILE is
+ * defined. */
+#ifdef SSO_PROFILE
+#define PROF_VAR(t) double t = 0
+#define PROF_START(t) ((t) = prof_now())
+#define PROF_LAP(p, phase, t, n)                                               \
+    do {                                                                       \
+        double prof_now_ = prof_now();                                         \
+        (p).time[phase] += prof_now_ - (t);                                    \
+        (p).calls[phase]++;                                                    \
+        (p).evals[phase] += (n);                                               \
+        (t) = prof_now_;                                                       \
+    } while (0)
+#else
+#define PROF_VAR(t)
+#define PROF_START(t) ((void)0)
+#define PROF_LAP(p, phase, t, n) ((void)0)
+#endif
+
+/* Wall clock time (s) usable from any thread */
+static inline double prof_now(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return MPI_Wtime();
+#endif
+}
+
+/* global best exchange struct */
+struct exchange_s {
+    MPI_Comm comm;          /* communicator (node leaders with a node) */
+    struct node_s *node;    /* node shared window (NULL: none) */
+    int nd;                 /* number of decision variables */
+    int reduce;             /* REDUCE_OP / REDUCE_LOC */
+    MPI_Datatype row_type;  /* solution plus value datatype */
+    MPI_Op op;              /* reduce operation */
+    num_t *send;            /* local best (nd + 1) */
+    num_t *recv;            /* global best (nd + 1) */
+    struct val_rank_s pair[2]; /* local and global (value, rank) */
+    MPI_Request req;        /* pending reduction or broadcast */
+    int active;             /* EXCHANGE_* state */
+    double start_time;      /* start of the pending reduction */
+    int count;              /* completed exchanges */
+    double wait_time;       /* time blocked in MPI_Wait (s) */
+    double flight_time;     /* time between start and completion (s) */
+};
+
+/* population checkpoint struct */
+struct checkpoint_s {
+    MPI_Comm comm;          /* communicator */
+    char *path;             /* checkpoint file */
+    char *tmp_path;         /* file being written (renamed when complete) */
+    int np;                 /* population size (all processes) */
+    int tc;                 /* test case */
+    MPI_File fh;            /* open tmp_path */
+    int64_t header[CKPT_HEADER_LEN]; /* header of the pending write */
+    num_t *buf;             /* packed local records */
+    MPI_Request req[2];     /* pending header and record writes */
+    int active;             /* write in progress */
+    int count;              /* completed checkpoints */
+    double wait_time;       /* time blocked completing writes (s) */
+};
+
+/* early termination struct */
+struct stop_s {
+    MPI_Comm comm;          /* communicator */
+    int window;             /* stagnation window (0: none) */
+    num_t tol;              /* relative improvement threshold */
+    int use_target;         /* stop when target is reached */
+    num_t target;           /* target (internal) */
+    num_t local;            /* best local value (pending reduction) */
+    num_t global;           /* best global value (pending reduction) */
+    num_t best;             /* best global value so far */
+    num_t *history;         /* best so far, last window + 1 iterations */
+    int n;                  /* completed reductions */
+    MPI_Request req;        /* pending reduction */
+    int active;             /* reduction in flight */
+    int reason;             /* STOP_* */
+};
+
+/* parameter sweep job struct */
+struct sweep_job_s {
+    int np;         /* population size */
+    int tc;         /* test case */
+    uint64_t seed;  /* PRNG seed */
+    int params_set; /* eta, alpha and beta given (else test case values) */
+    num_t eta;      /* eta */
+    num_t alpha;    /* alpha */
+    num_t beta;     /* beta */
+};
+
+/* parameter sweep result struct (message from a group to process 0) */
+struct sweep_result_s {
+    int job;         /* job index (-1: no result, first request) */
+    int group;       /* group index */
+    int processes;   /* processes in the group */
+    int threads;     /* threads per process */
+    int iterations;  /* iterations performed */
+    int stop_reason; /* STOP_* (early termination) */
+    long long evals; /* objective function evaluations */
+    double time;     /* elapsed time (s) */
+    num_t val;       /* best objective function value */
+};
+
+/* expression bytecode instruction struct */
+struct expr_insn_s {
+    int op;  /* opcode */
+    int dst; /* destination register */
+    int a;   /* first operand (register, index or loop) */
+    int b;   /* second operand (register or jump target) */
+    num_t c; /* immediate operand */
+};
+
+/* compiled expression struct */
+struct expr_prog_s {
+    int nd;                   /* number of decision variables */
+    int n;                    /* instructions */
+    int nregs;                /* registers used */
+    struct expr_insn_s *code; /* instructions (result in register 0) */
+};
+
+/* simulator worker struct */
+struct sim_worker_s {
+    pid_t pid;    /* process ID (-1: not running) */
+    int to;       /* request pipe (write end, -1: closed) */
+    int from;     /* response pipe (read end, -1: closed) */
+    num_t *buf;   /* packed request points */
+    size_t cap;   /* buf capacity (elements) */
+    int first;    /* index of the first point of the request in flight */
+    int pending;  /* points of the request in flight */
+};
+
+/* simulator worker pool struct (one per process) */
+struct sim_pool_s {
+    const char *cmd;             /* worker command (sh -c) */
+    int nd;                      /* number of decision variables */
+    int goal;                    /* MIN_GOAL / MAX_GOAL */
+    int threads;                 /* threads sharing the workers */
+    int n;                       /* workers */
+    struct sim_worker_s *worker; /* workers (contiguous range per thread) */
+    struct pollfd *pfd;          /* poll descriptors (one per worker) */
 };
 
 /* Function declarations */
 
 void print_usage(char *name);
+void init_run_opts(struct run_opts_s *opts);
+int parse_options(int argc, char *argv[], int rank, struct run_opts_s *opts);
 void init_tc_params(struct tc_params_s *tc_params);
+void init_func_tc_params(struct tc_params_s *tc_params,
+                         num_t (*obj_func)(num_t *, int),
+                         void (*obj_func_batch)(num_t *, int, int, int,
+                                                num_t *),
+                         int nd, num_t low, num_t high, int goal);
 void print_matrix(int rank, num_t **matrix, int m, int n);
 void print_vector(int rank, num_t *v, int length);
 
@@ -58,17 +618,166 @@ void free_2d_matrix(num_t ***M, int m);
 int allocate_3d_matrix(num_t ****M, int m, int n, int p);
 void free_3d_matrix(num_t ****M, int m, int n);
 
-void init_positions(num_t **X, int np, int nd, num_t low, num_t high);
+/* Population arena functions */
+size_t population_size(int np, int nd, int flags);
+int population_alloc(struct population_s *pop, int np, int nd, int flags);
+void population_reset(struct population_s *pop);
+void population_free(struct population_s *pop);
+
+void init_positions(struct population_s *pop, num_t low, num_t high);
 int gradient(num_t (*f)(num_t *, int), num_t *X, int nd, num_t *result);
+int gradient_ws_alloc(struct grad_ws_s *ws, int nd, int batch);
+void gradient_ws_free(struct grad_ws_s *ws);
+void gradient_ws(num_t (*f)(num_t *, int), num_t *X, int nd,
+                 struct grad_ws_s *ws, num_t *result);
+void gradient_stencil_fill(num_t *X, int nd, int rows, num_t *stencil);
+void gradient_stencil(num_t *X, int nd, int first, int n, double h,
+                      num_t *stencil);
+void gradient_stencil_restore(num_t *X, int nd, int first, int n,
+                              num_t *stencil);
+void eval_batch(const struct tc_params_s *tc_params, num_t *X, int n, int ld,
+                num_t *result);
+int check_gradient(const struct tc_params_s *tc_params, uint64_t seed,
+                   int first, int n_points,
+                   num_t *max_err);
 int min_abs(num_t a, num_t b);
-int compute_best_solution(struct tc_params_s tc_params, num_t **X, int np,
-                          num_t *best_solution, num_t *best_val);
+int thread_num(void);
+int max_threads(void);
+void set_num_threads(int n);
+long peak_rss(void);
+int compute_best_solution(struct tc_params_s tc_params,
+                          struct population_s *pop,
+                          const struct run_opts_s *opts, MPI_Comm comm,
+                          num_t *best_solution, num_t *best_val,
+                          struct run_stats_s *stats);
+
+/* Evaluation cache */
+int eval_cache_alloc(struct eval_cache_s *c, int nd, int slots, int batch);
+void eval_cache_free(struct eval_cache_s *c);
+void eval_cached(const struct tc_params_s *tc_params, struct eval_cache_s *c,
+                 num_t *X, int n, int ld, num_t *result);
+
+/* Gradient estimators */
+int gradient_estimator(const char *name);
+const char *gradient_name(int est);
+int gradient_configure(struct tc_params_s *tc_params, int est, num_t step_rel,
+                       int draws);
+int gradient_evals(const struct tc_params_s *tc_params);
+void gradient_central(const struct tc_params_s *tc_params,
+                      struct eval_cache_s *c, num_t *X, double h,
+                      struct grad_ws_s *ws, num_t *result);
+void gradient_forward(const struct tc_params_s *tc_params,
+                      struct eval_cache_s *c, num_t *X, num_t fx, int fx_known,
+                      double h, struct grad_ws_s *ws, num_t *result);
+void gradient_spsa(const struct tc_params_s *tc_params,
+                   struct eval_cache_s *c, num_t *X, double h, uint64_t seed,
+                   int shark, int k, struct grad_ws_s *ws, num_t *result);
+
+/* Solver kernels */
+shark_step_t select_kernel(const struct tc_params_s *tc_params, int generic,
+                           const char **name);
+
+/* Global best exchange */
+int argmax(const num_t *v, int n);
+int argmin(const num_t *v, int n);
+int exchange_init(struct exchange_s *ex, MPI_Comm comm, struct node_s *node,
+                  int nd, int reduce);
+void exchange_start(struct exchange_s *ex, struct population_s *pop);
+void exchange_progress(struct exchange_s *ex);
+void exchange_finish(struct exchange_s *ex, struct population_s *pop);
+void exchange_free(struct exchange_s *ex);
+
+/* Checkpoint/restart */
+int checkpoint_init(struct checkpoint_s *ck, MPI_Comm comm, const char *path,
+                    int np, int tc, const struct population_s *pop);
+int checkpoint_start(struct checkpoint_s *ck, const struct population_s *pop);
+void checkpoint_progress(struct checkpoint_s *ck);
+int checkpoint_finish(struct checkpoint_s *ck);
+int checkpoint_free(struct checkpoint_s *ck);
+int checkpoint_read(const char *path, MPI_Comm comm, int np, int tc,
+                    struct population_s *pop);
+
+/* Early termination */
+int stop_init(struct stop_s *st, MPI_Comm comm, int window, num_t tol,
+              int use_target, num_t target);
+void stop_progress(struct stop_s *st);
+int stop_update(struct stop_s *st, num_t local_best);
+void stop_free(struct stop_s *st);
+
+/* Node shared memory */
+int node_init(struct node_s *node, MPI_Comm comm, int nd, size_t pop_size,
+              void **pop_arena);
+void node_reduce(struct node_s *node, int goal, num_t *best,
+                 struct node_stats_s *stats);
+void node_stats_reduce(const struct node_stats_s *stats,
+                       struct node_stats_s *result, MPI_Comm comm);
+void node_free(struct node_s *node);
+
+/* Objective function plugins */
+int plugin_load(const char *path, struct tc_params_s *tc_params,
+                const char **name, void **handle);
+void plugin_close(void *handle);
+
+/* Objective functions from expressions */
+int expr_compile(const char *text, int nd, int goal, struct expr_prog_s *prog,
+                 char *err, size_t errlen);
+int expr_bcast(struct expr_prog_s *prog, int root, MPI_Comm comm);
+void expr_free(struct expr_prog_s *prog);
+void expr_eval(const struct expr_prog_s *prog, num_t *X, int n, int ld,
+               num_t *result);
+void expr_set_active(const struct expr_prog_s *prog);
+num_t expr_obj_func(num_t *X, int nd);
+void expr_obj_func_batch(num_t *X, int n, int nd, int ld, num_t *result);
+
+/* Objective functions computed by simulator workers */
+int sim_start(struct sim_pool_s *pool, const char *cmd, int n, int threads,
+              int nd, int goal);
+void sim_stop(struct sim_pool_s *pool);
+void sim_set_active(struct sim_pool_s *pool);
+num_t sim_obj_func(num_t *X, int nd);
+void sim_obj_func_batch(num_t *X, int n, int nd, int ld, num_t *result);
+
+/* Dynamic load balancing */
+int run_dynamic(struct tc_params_s tc_params, const struct run_opts_s *opts,
+                int np, MPI_Comm comm, num_t *best_solution, num_t *best_val,
+                struct run_stats_s *stats);
+
+/* Decision variables decomposition */
+int run_decomposed(struct tc_params_s tc_params, const struct run_opts_s *opts,
+                   int np, MPI_Comm comm, num_t *best_solution,
+                   num_t *best_val, struct run_stats_s *stats);
+
+/* Parameter sweep */
+int run_sweep(struct tc_params_s *tc_params, const struct run_opts_s *opts,
+              MPI_Comm comm);
+
+/* Counter-based PRNG */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+void rng_fill_uniform(uint64_t seed, uint32_t stream, uint32_t shark,
+                      uint32_t iter, uint32_t first, int n, num_t *out);
+num_t rng_uniform(uint64_t seed, uint32_t stream, uint32_t shark,
+                  uint32_t iter, uint32_t draw);
+
+/* Profiling */
+void prof_merge(struct prof_s *dst, const struct prof_s *src);
+int prof_report(const struct prof_s *prof, MPI_Comm comm,
+                const char *json_file);
 
 /* Custom reduce operations */
 void find_max_val(void *in_param, void *inout_param, int *len,
                   MPI_Datatype *dt);
 void find_min_val(void *in_param, void *inout_param, int *len,
                   MPI_Datatype *dt);
+void reduce_best(num_t *solution, num_t *result, int nd, int goal, int root,
+                 MPI_Comm comm);
+void allreduce_best(num_t *solution, num_t *result, int nd, int goal,
+                    MPI_Comm comm);
+void sum_prod(void *in_param, void *inout_param, int *len, MPI_Datatype *dt);
+void merge_topk(void *in_param, void *inout_param, int *len,
+                MPI_Datatype *dt);
+int topk_init(struct topk_s *t, int k, int nd, num_t dist);
+int topk_select(struct topk_s *t, num_t **X, const num_t *vals, int n);
+void topk_free(struct topk_s *t);
 
 /* Objective functions */
 num_t elliptic_paraboloid(num_t *X, int nd);
@@ -77,5 +786,35 @@ num_t flipped_goldstein_price(num_t *X, int nd);
 num_t rastrigin(num_t *X, int nd);
 num_t griewangk(num_t *X, int nd);
 num_t schaffer(num_t *X, int nd);
+num_t variable_cost(num_t *X, int nd);
+
+/* Batched objective functions (n vectors, one every ld elements) */
+void elliptic_paraboloid_batch(num_t *X, int n, int nd, int ld, num_t *result);
+void goldstein_price_batch(num_t *X, int n, int nd, int ld, num_t *result);
+void flipped_goldstein_price_batch(num_t *X, int n, int nd, int ld,
+                                   num_t *result);
+void rastrigin_batch(num_t *X, int n, int nd, int ld, num_t *result);
+void griewangk_batch(num_t *X, int n, int nd, int ld, num_t *result);
+void schaffer_batch(num_t *X, int n, int nd, int ld, num_t *result);
+
+/* Objective functions gradients */
+void elliptic_paraboloid_grad(num_t *X, int nd, num_t *result);
+void goldstein_price_grad(num_t *X, int nd, num_t *result);
+void flipped_goldstein_price_grad(num_t *X, int nd, num_t *result);
+void rastrigin_grad(num_t *X, int nd, num_t *result);
+void griewangk_grad(num_t *X, int nd, num_t *result);
+void schaffer_grad(num_t *X, int nd, num_t *result);
+
+/* Objective functions decomposed over the decision variables */
+void rastrigin_partial(num_t *X, int n, int ld, int j0, int nj, num_t *sp);
+num_t rastrigin_value(const num_t *sp, int nd);
+void rastrigin_grad_partial(num_t *X, int j0, int nj, num_t p_other,
+                            num_t *result);
+void griewangk_partial(num_t *X, int n, int ld, int j0, int nj, num_t *sp);
+num_t griewangk_value(const num_t *sp, int nd);
+void griewangk_grad_partial(num_t *X, int j0, int nj, num_t p_other,
+                            num_t *result);
+extern const struct decomp_func_s rastrigin_decomp;
+extern const struct decomp_func_s griewangk_decomp;
 
 #endif /* SSO_H */
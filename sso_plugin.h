@@ -0,0 +1,63 @@
+/*
+ * Objective function plugin interface.
+ *
+ * A plugin is a shared object exporting a struct sso_plugin_s named
+ * SSO_PLUGIN_SYMBOL ("sso_plugin"), loaded with dlopen() by every process at
+ * startup (--plugin FILE). Its function pointers are then called directly by
+ * the solver.
+ * The solver always maximizes: for a minimization problem (goal
+ * SSO_PLUGIN_MIN) the functions must return -f(x) and its gradient, as the
+ * built-in test cases do.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+#ifndef SSO_PLUGIN_H
+#define SSO_PLUGIN_H
+
+/* Interface version (checked when the plugin is loaded) */
+#define SSO_PLUGIN_ABI 1
+
+/* Name of the exported descriptor */
+#define SSO_PLUGIN_SYMBOL "sso_plugin"
+
+/* Goals */
+#define SSO_PLUGIN_MIN -1
+#define SSO_PLUGIN_MAX 1
+
+/* Floating point type of decision variables and values: it must match the
+ * num_t of the solver build (define SSO_FLOAT or SSO_MIXED when building
+ * plugins for the single-precision solver builds) */
+#if defined(SSO_FLOAT) || defined(SSO_MIXED)
+typedef float sso_num_t;
+#else
+typedef double sso_num_t;
+#endif
+
+/* plugin descriptor struct */
+struct sso_plugin_s {
+    int abi;                /* SSO_PLUGIN_ABI */
+    int num_size;           /* sizeof(sso_num_t) */
+    const char *name;       /* objective function name */
+    int nd;                 /* number of decision variables */
+    sso_num_t low;          /* decision variables lower bound */
+    sso_num_t high;         /* decision variables upper bound */
+    int goal;               /* SSO_PLUGIN_MIN / SSO_PLUGIN_MAX */
+    sso_num_t eta;          /* eta */
+    sso_num_t alpha;        /* alpha */
+    sso_num_t beta;         /* beta */
+    sso_num_t delta_t;      /* delta_t */
+    int m_points;           /* M (local search) */
+    int k_max;              /* K_MAX (iterations) */
+    sso_num_t initial_velocity; /* initial velocity */
+
+    /* objective function (required) */
+    sso_num_t (*obj_func)(sso_num_t *X, int nd);
+    /* batched objective function (optional): n vectors, one every ld
+     * elements */
+    void (*obj_func_batch)(sso_num_t *X, int n, int nd, int ld,
+                           sso_num_t *result);
+    /* gradient (optional) */
+    void (*grad_func)(sso_num_t *X, int nd, sso_num_t *result);
+};
+
+#endif
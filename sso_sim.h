@@ -0,0 +1,48 @@
+/*
+ * Simulator worker protocol.
+ *
+ * With --sim CMD every process starts --sim-workers copies of the shell
+ * command CMD and keeps them running for the whole run. A worker reads
+ * requests from its standard input and writes one response per request to
+ * its standard output; both are frames made of a struct sso_sim_frame_s
+ * header followed by the payload (native byte order, no padding):
+ * - hello (worker to solver, once at startup): n = 0, nd = 0, no payload
+ * - request (solver to worker): n points of nd decision variables each
+ *   (n * nd values)
+ * - response (worker to solver): the n objective function values of the
+ *   request, in the same order (status 0), or no payload (status != 0:
+ *   evaluation error, the run is aborted)
+ * Workers must return the objective function value itself (the solver
+ * handles --goal) and exit when their standard input is closed.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+#ifndef SSO_SIM_H
+#define SSO_SIM_H
+
+#include <stdint.h>
+
+/* Frame magic number ("SSOS") and protocol version */
+#define SSO_SIM_MAGIC 0x534f5353u
+#define SSO_SIM_VERSION 1
+
+/* Floating point type of decision variables and values: it must match the
+ * num_t of the solver build (checked with the num_size field of the hello
+ * frame) */
+#if defined(SSO_FLOAT) || defined(SSO_MIXED)
+typedef float sso_sim_num_t;
+#else
+typedef double sso_sim_num_t;
+#endif
+
+/* frame header struct */
+struct sso_sim_frame_s {
+    uint32_t magic;    /* SSO_SIM_MAGIC */
+    uint32_t version;  /* SSO_SIM_VERSION */
+    uint32_t num_size; /* sizeof(sso_sim_num_t) */
+    uint32_t status;   /* 0: success (responses) */
+    uint32_t n;        /* points */
+    uint32_t nd;       /* decision variables per point (requests) */
+};
+
+#endif
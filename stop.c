@@ -0,0 +1,135 @@
+/*
+ * Convergence-based early termination.
+ *
+ * At the end of each iteration the best local objective function value is
+ * reduced with a non-blocking MPI_Iallreduce, which is completed at the end of
+ * the next iteration. The stopping criteria are then checked on the completed
+ * global best, so that every process takes the same decision at the same
+ * iteration (one iteration after the criterion is met).
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/*
+ * This function initializes early termination.
+ *
+ * Input parameters
+ * - comm: communicator
+ * - window: stop if the global best improved by at most
+ *   tol * max(|best|, STOP_MIN_SCALE) in the last window iterations (0:
+ *   never)
+ * - tol: relative improvement threshold (0: stop on stagnation)
+ * - use_target: stop when the global best reaches target
+ * - target: target (internal, maximized objective function value)
+ *
+ * Output parameters
+ * - st: early termination state
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int stop_init(struct stop_s *st, MPI_Comm comm, int window, num_t tol,
+              int use_target, num_t target)
+{
+    st->comm = comm;
+    st->window = window;
+    st->tol = tol;
+    st->use_target = use_target;
+    st->target = target;
+    st->active = 0;
+    st->n = 0;
+    st->best = -HUGE_VAL;
+    st->reason = STOP_NONE;
+
+    st->history = (num_t *)malloc((window + 1) * sizeof(num_t));
+    if (st->history == NULL) {
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * This function lets MPI progress the pending reduction.
+ *
+ * Input parameters
+ * - st: early termination state
+ */
+void stop_progress(struct stop_s *st)
+{
+    int flag;
+
+    if (st->active) {
+        MPI_Test(&st->req, &flag, MPI_STATUS_IGNORE);
+    }
+}
+
+/*
+ * This function completes the reduction started at the end of the previous
+ * iteration, checks the stopping criteria and, unless the run has to stop,
+ * starts the reduction of the best local value of this iteration. Every
+ * process in st->comm must call it at the end of every iteration.
+ *
+ * Input parameters
+ * - st: early termination state
+ * - local_best: best local objective function value (internal)
+ *
+ * Return value
+ * It returns STOP_NONE if the run can go on, otherwise the criterion which
+ * was met (STOP_TARGET / STOP_STAGNATION).
+ */
+int stop_update(struct stop_s *st, num_t local_best)
+{
+    num_t old; /* best value window iterations ago */
+
+    if (st->active) {
+        MPI_Wait(&st->req, MPI_STATUS_IGNORE);
+        st->active = 0;
+
+        /* Best value so far (sharks may move to worse positions) */
+        st->best = MAX(st->best, st->global);
+        st->history[st->n % (st->window + 1)] = st->best;
+        st->n++;
+
+        if (st->use_target && st->best >= st->target) {
+            st->reason = STOP_TARGET;
+        } else if (st->window > 0 && st->n > st->window) {
+            old = st->history[(st->n - 1 - st->window) % (st->window + 1)];
+            if (st->best - old <= st->tol * MAX(fabs(old), STOP_MIN_SCALE)) {
+                st->reason = STOP_STAGNATION;
+            }
+        }
+    }
+
+    if (st->reason == STOP_NONE) {
+        st->local = local_best;
+        MPI_Iallreduce(&st->local, &st->global, 1, NUM_DT, MPI_MAX, st->comm,
+                       &st->req);
+        st->active = 1;
+    }
+
+    return st->reason;
+}
+
+/*
+ * This function completes the pending reduction (if any) and frees early
+ * termination state.
+ *
+ * Input parameters
+ * - st: early termination state
+ */
+void stop_free(struct stop_s *st)
+{
+    if (st->active) {
+        MPI_Wait(&st->req, MPI_STATUS_IGNORE);
+    }
+    free(st->history);
+}
@@ -0,0 +1,476 @@
+/*
+ * Parameter sweep: many independent runs in a single MPI launch.
+ *
+ * Each line of the job file describes a run: "NP TC [SEED [ETA ALPHA BETA]]"
+ * (blank lines and lines starting with '#' are ignored). Process 0 reads the
+ * job file and sends the jobs to every process. The other processes are
+ * split with MPI_Comm_split into groups of --group-size processes; the
+ * leader (rank 0) of each group requests a job from process 0 (master),
+ * which hands them out as the groups finish, and broadcasts it to its group,
+ * which runs it with the static distribution. The request of the next job
+ * carries the result of the previous one, which process 0 appends to the
+ * output file as soon as it arrives. Test case parameters are initialized
+ * once, and each process reuses its population arena between jobs. With a
+ * single process, every job is run by process 0.
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "sso.h"
+
+#include "mpi.h"
+
+/* Message tags */
+#define TAG_RESULT 1 /* leader -> master: result of a job, request a job */
+#define TAG_JOB 2    /* master -> leader: job index (-1: stop) */
+
+/*
+ * This function reads the job file.
+ *
+ * Input parameters
+ * - path: job file
+ * - seed: seed of the jobs without one
+ * - min_np: smallest valid population size (processes per group)
+ *
+ * Output parameters
+ * - jobs: jobs (to be freed by the caller)
+ * - n: number of jobs
+ * - line_no: line of the first invalid job
+ *
+ * Return value
+ * It returns -2 if a job is not valid.
+ * It returns -1 if the file could not be read or a memory allocation problem
+ * occurred.
+ * It returns 1 on success.
+ */
+static int read_jobs(const char *path, uint64_t seed, int min_np,
+                     struct sweep_job_s **jobs, int *n, int *line_no)
+{
+    FILE *f;
+    char line[SWEEP_LINE_LEN];
+    char *tok[7];   /* fields (at most 6, one more to detect extra ones) */
+    char *endptr;   /* location of the first invalid char (strtol) */
+    int n_tok;
+    int capacity = 0;
+    struct sweep_job_s *job;
+    struct sweep_job_s *tmp;
+    int ok;
+
+    *jobs = NULL;
+    *n = 0;
+    *line_no = 0;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        (*line_no)++;
+
+        for (n_tok = 0; n_tok < 7; n_tok++) {
+            tok[n_tok] = strtok(n_tok == 0 ? line : NULL, " \t\r\n");
+            if (tok[n_tok] == NULL) {
+                break;
+            }
+        }
+        if (n_tok == 0 || tok[0][0] == '#') {
+            continue;
+        }
+        if (n_tok != 2 && n_tok != 3 && n_tok != 6) {
+            fclose(f);
+            return -2;
+        }
+
+        if (*n == capacity) {
+            capacity = capacity > 0 ? 2 * capacity : 64;
+            tmp = (struct sweep_job_s *)realloc(*jobs,
+                                                capacity * sizeof(**jobs));
+            if (tmp == NULL) {
+                fclose(f);
+                return -1;
+            }
+            *jobs = tmp;
+        }
+        job = &(*jobs)[*n];
+
+        errno = 0;
+        job->np = (int)strtol(tok[0], &endptr, 10);
+        ok = *endptr == '\0' && job->np >= min_np;
+        job->tc = (int)strtol(tok[1], &endptr, 10);
+        ok = ok && *endptr == '\0' && job->tc >= 0 && job->tc < NUM_OF_TC;
+        job->seed = seed;
+        if (n_tok > 2) {
+            job->seed = (uint64_t)strtoull(tok[2], &endptr, 10);
+            ok = ok && *endptr == '\0';
+        }
+        job->params_set = n_tok == 6;
+        if (job->params_set) {
+            job->eta = (num_t)strtod(tok[3], &endptr);
+            ok = ok && *endptr == '\0';
+            job->alpha = (num_t)strtod(tok[4], &endptr);
+            ok = ok && *endptr == '\0';
+            job->beta = (num_t)strtod(tok[5], &endptr);
+            ok = ok && *endptr == '\0';
+        }
+        if (!ok || errno != 0) {
+            fclose(f);
+            return -2;
+        }
+        (*n)++;
+    }
+    fclose(f);
+
+    return 1;
+}
+
+/*
+ * This function runs a job on a group of processes (every process in group
+ * must call it).
+ *
+ * Input parameters
+ * - tc_params: test case parameters array
+ * - opts: run options
+ * - job: job
+ * - group: communicator
+ * - pop: population (its arena is reused between jobs)
+ * - solution: scratch space (length: nd + 1)
+ *
+ * Output parameters
+ * - best_solution: best solution (length: nd, leader only)
+ * - res: result (leader only)
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+static int run_job(const struct tc_params_s *tc_params,
+                   const struct run_opts_s *opts,
+                   const struct sweep_job_s *job, MPI_Comm group,
+                   struct population_s *pop, num_t *solution,
+                   num_t *best_solution, struct sweep_result_s *res)
+{
+    struct tc_params_s params = tc_params[job->tc];
+    struct run_opts_s job_opts = *opts;
+    struct run_stats_s stats;
+    num_t val;
+    int rank, size;
+    double t;
+
+    MPI_Comm_rank(group, &rank);
+    MPI_Comm_size(group, &size);
+
+    if (job->params_set) {
+        params.eta = job->eta;
+        params.alpha = job->alpha;
+        params.beta = job->beta;
+    }
+    job_opts.np = job->np;
+    job_opts.tc = job->tc;
+    job_opts.seed = job->seed;
+    if (job_opts.reduce == REDUCE_AUTO) {
+        job_opts.reduce = params.nd >= REDUCE_LOC_MIN_ND ? REDUCE_LOC
+                                                         : REDUCE_OP;
+    }
+
+    MPI_Barrier(group);
+    t = MPI_Wtime();
+
+    /* This process handles the sharks whose global indices start from
+     * (rank * np) / size */
+    if (population_alloc(pop, ((rank + 1) * job->np) / size -
+                                  (rank * job->np) / size,
+                         params.nd, opts->pop_flags) == -1) {
+        return -1;
+    }
+    pop->offset = (rank * job->np) / size;
+    pop->seed = job->seed;
+    init_positions(pop, params.low, params.high);
+
+    if (compute_best_solution(params, pop, &job_opts, group, solution, &val,
+                              &stats) == -1) {
+        return -1;
+    }
+    solution[params.nd] = val;
+
+    reduce_best(solution, best_solution, params.nd, params.goal, 0, group);
+    MPI_Reduce(&stats.iterations, &res->iterations, 1, MPI_INT, MPI_MAX, 0,
+               group);
+    MPI_Reduce(&stats.stop_reason, &res->stop_reason, 1, MPI_INT, MPI_MAX, 0,
+               group);
+    MPI_Reduce(&stats.evals, &res->evals, 1, MPI_LONG_LONG, MPI_SUM, 0,
+               group);
+
+    res->time = MPI_Wtime() - t;
+    res->processes = size;
+    res->threads = max_threads();
+    res->val = best_solution[params.nd];
+
+    return 1;
+}
+
+/*
+ * This function appends the result of a job to the output file.
+ *
+ * Input parameters
+ * - out: output file
+ * - jobs: jobs
+ * - tc_params: test case parameters array
+ * - res: result
+ * - best_solution: best solution
+ */
+static void write_result(FILE *out, const struct sweep_job_s *jobs,
+                         const struct tc_params_s *tc_params,
+                         const struct sweep_result_s *res,
+                         const num_t *best_solution)
+{
+    const struct sweep_job_s *job = &jobs[res->job];
+    const struct tc_params_s *params = &tc_params[job->tc];
+    int i;
+
+    fprintf(out, "%d,%d,%d,%llu,%g,%g,%g,%d,%d,%d,%.6f,%d,%lld,%d,%.9e,",
+            res->job, job->np, job->tc, (unsigned long long)job->seed,
+            job->params_set ? job->eta : params->eta,
+            job->params_set ? job->alpha : params->alpha,
+            job->params_set ? job->beta : params->beta, res->group,
+            res->processes, res->threads, res->time, res->iterations,
+            res->evals, res->stop_reason, res->val);
+    for (i = 0; i < params->nd; i++) {
+        fprintf(out, i > 0 ? " %.9e" : "%.9e", best_solution[i]);
+    }
+    fprintf(out, "\n");
+    fflush(out); /* results are streamed */
+}
+
+/*
+ * This function hands out the jobs to the group leaders and writes their
+ * results until every job is done, then tells every leader to stop.
+ *
+ * Input parameters
+ * - jobs: jobs
+ * - n: number of jobs
+ * - tc_params: test case parameters array
+ * - out: output file
+ * - groups: number of groups
+ * - best_solution: scratch space (length: largest nd)
+ * - comm: communicator (master is process 0)
+ *
+ * Output parameters
+ * - job_time: sum of the elapsed times of the jobs
+ */
+static void master(const struct sweep_job_s *jobs, int n,
+                   const struct tc_params_s *tc_params, FILE *out, int groups,
+                   num_t *best_solution, MPI_Comm comm, double *job_time)
+{
+    struct sweep_result_s res;
+    int next = 0;    /* next job */
+    int stopped = 0; /* leaders told to stop */
+    int reply;
+    MPI_Status status;
+
+    *job_time = 0;
+
+    while (stopped < groups) {
+        MPI_Recv(&res, sizeof(res), MPI_BYTE, MPI_ANY_SOURCE, TAG_RESULT,
+                 comm, &status);
+
+        /* The solution follows the result (messages from the same process
+         * are not overtaken) */
+        if (res.job >= 0) {
+            MPI_Recv(best_solution, tc_params[jobs[res.job].tc].nd, NUM_DT,
+                     status.MPI_SOURCE, TAG_RESULT, comm, MPI_STATUS_IGNORE);
+            write_result(out, jobs, tc_params, &res, best_solution);
+            *job_time += res.time;
+        }
+
+        if (next < n) {
+            reply = next++;
+        } else {
+            reply = -1;
+            stopped++;
+        }
+
+        MPI_Send(&reply, 1, MPI_INT, status.MPI_SOURCE, TAG_JOB, comm);
+    }
+}
+
+/*
+ * This function runs the jobs of the parameter sweep opts->sweep and writes
+ * their results to opts->sweep_out (one line per job, in completion order).
+ * Error messages are only printed by process 0.
+ *
+ * Input parameters
+ * - tc_params: test case parameters array
+ * - opts: run options (opts->group_size: processes per group)
+ * - comm: communicator
+ *
+ * Return value
+ * It returns -2 if the job file or the output file are not valid.
+ * It returns -1 if a memory allocation problem occurred.
+ * It returns 1 on success.
+ */
+int run_sweep(struct tc_params_s *tc_params, const struct run_opts_s *opts,
+              MPI_Comm comm)
+{
+    struct sweep_job_s *jobs = NULL;
+    struct sweep_result_s res;
+    struct population_s pop = {0}; /* job population (arena reused) */
+    num_t *solution;      /* local best solution, then the group best one */
+    FILE *out = NULL;
+    MPI_Comm group = MPI_COMM_NULL;
+    int rank, size;
+    int group_size;       /* processes per group */
+    int groups;           /* number of groups */
+    int last_size;        /* processes of the last group (the remainder) */
+    int n;                /* number of jobs (negative: error) */
+    int line_no;
+    int max_nd = 1;
+    int status = 1;
+    int i;
+    double elapsed_time;
+    double job_time = 0;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    group_size = size == 1 ? 1 : MIN(opts->group_size, size - 1);
+    groups = size == 1 ? 1 : (size - 1 + group_size - 1) / group_size;
+    last_size = size == 1 ? 1 : size - 1 - (groups - 1) * group_size;
+
+    /* Process 0 reads the jobs and opens the output file */
+    if (rank == 0) {
+        status = read_jobs(opts->sweep, opts->seed, group_size, &jobs, &n,
+                           &line_no);
+        if (status == -1) {
+            printf("error: cannot read job file %s\n", opts->sweep);
+            n = -1;
+        } else if (status == -2) {
+            printf("error: invalid job at %s:%d (expected \"NP TC [SEED "
+                   "[ETA ALPHA BETA]]\", NP >= %d, 0 <= TC < %d)\n",
+                   opts->sweep, line_no, group_size, NUM_OF_TC);
+            n = -1;
+        } else if (n == 0) {
+            printf("error: no jobs in %s\n", opts->sweep);
+            n = -1;
+        } else {
+            out = fopen(opts->sweep_out, "w");
+            if (out == NULL) {
+                printf("error: cannot write %s\n", opts->sweep_out);
+                n = -1;
+            }
+        }
+    }
+    MPI_Bcast(&n, 1, MPI_INT, 0, comm);
+    if (n < 0) {
+        free(jobs);
+        return -2;
+    }
+
+    /* Every process gets the jobs */
+    if (rank != 0) {
+        jobs = (struct sweep_job_s *)malloc(n * sizeof(*jobs));
+        if (jobs == NULL) {
+            return -1;
+        }
+    }
+    MPI_Bcast(jobs, n * sizeof(*jobs), MPI_BYTE, 0, comm);
+    for (i = 0; i < n; i++) {
+        max_nd = MAX(max_nd, tc_params[jobs[i].tc].nd);
+    }
+
+    /* Scratch space: local best solution, then best solution of the group */
+    solution = (num_t *)malloc(2 * (max_nd + 1) * sizeof(num_t));
+    if (solution == NULL) {
+        free(jobs);
+        return -1;
+    }
+
+    if (rank == 0) {
+        printf("Parameter sweep: %d jobs from %s, %d groups of %d processes",
+               n, opts->sweep, groups, group_size);
+        if (last_size != group_size) {
+            printf(" (last group: %d)", last_size);
+        }
+        printf(", threads per process: %d\n", max_threads());
+        fflush(stdout);
+        fprintf(out, "job,np,tc,seed,eta,alpha,beta,group,processes,threads,"
+                     "time,iterations,evals,stop_reason,best,solution\n");
+    }
+
+    elapsed_time = -MPI_Wtime();
+
+    if (size == 1) {
+        res.group = 0;
+        for (i = 0; i < n && status == 1; i++) {
+            res.job = i;
+            status = run_job(tc_params, opts, &jobs[i], MPI_COMM_SELF, &pop,
+                             solution, &solution[max_nd + 1], &res);
+            if (status == 1) {
+                write_result(out, jobs, tc_params, &res,
+                             &solution[max_nd + 1]);
+                job_time += res.time;
+            }
+        }
+    } else if (rank == 0) {
+        MPI_Comm_split(comm, MPI_UNDEFINED, 0, &group);
+        master(jobs, n, tc_params, out, groups, solution, comm, &job_time);
+    } else {
+        MPI_Comm_split(comm, (rank - 1) / group_size, rank, &group);
+
+        res.job = -1;
+        res.group = (rank - 1) / group_size;
+        for (;;) {
+            if (rank == 1 + res.group * group_size) {
+                MPI_Send(&res, sizeof(res), MPI_BYTE, 0, TAG_RESULT, comm);
+                if (res.job >= 0) {
+                    MPI_Send(&solution[max_nd + 1],
+                             tc_params[jobs[res.job].tc].nd, NUM_DT, 0,
+                             TAG_RESULT, comm);
+                }
+                MPI_Recv(&res.job, 1, MPI_INT, 0, TAG_JOB, comm,
+                         MPI_STATUS_IGNORE);
+            }
+            MPI_Bcast(&res.job, 1, MPI_INT, 0, group);
+            if (res.job < 0) {
+                break;
+            }
+            status = run_job(tc_params, opts, &jobs[res.job], group, &pop,
+                             solution, &solution[max_nd + 1], &res);
+            if (status == -1) {
+                /* The master (and the other processes of the group) would
+                 * wait for the result of this group forever */
+                printf("(%d): memory allocation error in job %d\n", rank,
+                       res.job);
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+        }
+    }
+
+    elapsed_time += MPI_Wtime();
+
+    if (rank == 0 && status == 1) {
+        printf("Total elapsed time (seconds): %8.6f, sum of job times: "
+               "%8.6f (%.1f%% of %d groups)\n", elapsed_time, job_time,
+               100.0 * job_time / (elapsed_time * groups), groups);
+        printf("Results written to %s\n", opts->sweep_out);
+        fflush(stdout);
+    }
+
+    if (out != NULL) {
+        fclose(out);
+    }
+    if (group != MPI_COMM_NULL) {
+        MPI_Comm_free(&group);
+    }
+    population_free(&pop);
+    free(solution);
+    free(jobs);
+
+    return status;
+}
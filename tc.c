@@ -21,6 +21,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[0].high = 100;
     tc_params[0].goal = MIN_GOAL;
     tc_params[0].obj_func = elliptic_paraboloid;
+    tc_params[0].obj_func_batch = elliptic_paraboloid_batch;
+    tc_params[0].grad_func = elliptic_paraboloid_grad;
     tc_params[0].eta = 0.3;
     tc_params[0].alpha = 0.1;
     tc_params[0].beta = 4;
@@ -28,6 +30,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[0].m_points = 20;
     tc_params[0].k_max = 30;
     tc_params[0].initial_velocity = 0.5;
+    tc_params[0].decomp = NULL;
+    tc_params[0].any_nd = 0;
+    tc_params[0].grad_est = GRAD_ANALYTIC;
+    tc_params[0].grad_step = D_INCR;
+    tc_params[0].spsa_draws = 1;
 
     /* Goldstein-Price function */
     tc_params[1].nd = 2;
@@ -35,6 +42,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[1].high = 2;
     tc_params[1].goal = MIN_GOAL;
     tc_params[1].obj_func = goldstein_price;
+    tc_params[1].obj_func_batch = goldstein_price_batch;
+    tc_params[1].grad_func = goldstein_price_grad;
     tc_params[1].eta = 0.002;
     tc_params[1].alpha = 0.1;
     tc_params[1].beta = 3;
@@ -42,6 +51,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[1].m_points = 20;
     tc_params[1].k_max = 30;
     tc_params[1].initial_velocity = 0.5;
+    tc_params[1].decomp = NULL;
+    tc_params[1].any_nd = 0;
+    tc_params[1].grad_est = GRAD_ANALYTIC;
+    tc_params[1].grad_step = D_INCR;
+    tc_params[1].spsa_draws = 1;
 
     /* "Flipped" Goldstein-Price function */
     tc_params[2].nd = 2;
@@ -49,6 +63,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[2].high = 2;
     tc_params[2].goal = MAX_GOAL;
     tc_params[2].obj_func = flipped_goldstein_price;
+    tc_params[2].obj_func_batch = flipped_goldstein_price_batch;
+    tc_params[2].grad_func = flipped_goldstein_price_grad;
     tc_params[2].eta = 0.002;
     tc_params[2].alpha = 0.1;
     tc_params[2].beta = 3;
@@ -56,6 +72,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[2].m_points = 20;
     tc_params[2].k_max = 30;
     tc_params[2].initial_velocity = 0.5;
+    tc_params[2].decomp = NULL;
+    tc_params[2].any_nd = 0;
+    tc_params[2].grad_est = GRAD_ANALYTIC;
+    tc_params[2].grad_step = D_INCR;
+    tc_params[2].spsa_draws = 1;
 
     /* Rastrigin function (two decision variables) */
     tc_params[3].nd = 2;
@@ -63,6 +84,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[3].high = 20;
     tc_params[3].goal = MIN_GOAL;
     tc_params[3].obj_func = rastrigin;
+    tc_params[3].obj_func_batch = rastrigin_batch;
+    tc_params[3].grad_func = rastrigin_grad;
     tc_params[3].eta = 0.9;
     tc_params[3].alpha = 0.1;
     tc_params[3].beta = 4;
@@ -70,6 +93,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[3].m_points = 20;
     tc_params[3].k_max = 30;
     tc_params[3].initial_velocity = 0.5;
+    tc_params[3].decomp = &rastrigin_decomp;
+    tc_params[3].any_nd = 1;
+    tc_params[3].grad_est = GRAD_ANALYTIC;
+    tc_params[3].grad_step = D_INCR;
+    tc_params[3].spsa_draws = 1;
 
     /* Rastrigin function (five decision variables) */
     tc_params[4].nd = 5;
@@ -77,6 +105,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[4].high = 20;
     tc_params[4].goal = MIN_GOAL;
     tc_params[4].obj_func = rastrigin;
+    tc_params[4].obj_func_batch = rastrigin_batch;
+    tc_params[4].grad_func = rastrigin_grad;
     tc_params[4].eta = 0.9;
     tc_params[4].alpha = 0.1;
     tc_params[4].beta = 4;
@@ -84,6 +114,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[4].m_points = 20;
     tc_params[4].k_max = 30;
     tc_params[4].initial_velocity = 0.5;
+    tc_params[4].decomp = &rastrigin_decomp;
+    tc_params[4].any_nd = 1;
+    tc_params[4].grad_est = GRAD_ANALYTIC;
+    tc_params[4].grad_step = D_INCR;
+    tc_params[4].spsa_draws = 1;
 
     /* Griewangk function (two decision variables) */
     tc_params[5].nd = 2;
@@ -91,6 +126,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[5].high = 600;
     tc_params[5].goal = MIN_GOAL;
     tc_params[5].obj_func = griewangk;
+    tc_params[5].obj_func_batch = griewangk_batch;
+    tc_params[5].grad_func = griewangk_grad;
     tc_params[5].eta = 0.9;
     tc_params[5].alpha = 0.1;
     tc_params[5].beta = 4;
@@ -98,6 +135,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[5].m_points = 20;
     tc_params[5].k_max = 30;
     tc_params[5].initial_velocity = 0.5;
+    tc_params[5].decomp = &griewangk_decomp;
+    tc_params[5].any_nd = 1;
+    tc_params[5].grad_est = GRAD_ANALYTIC;
+    tc_params[5].grad_step = D_INCR;
+    tc_params[5].spsa_draws = 1;
 
     /* Griewangk function (five decision variables) */
     tc_params[6].nd = 5;
@@ -105,6 +147,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[6].high = 600;
     tc_params[6].goal = MIN_GOAL;
     tc_params[6].obj_func = griewangk;
+    tc_params[6].obj_func_batch = griewangk_batch;
+    tc_params[6].grad_func = griewangk_grad;
     tc_params[6].eta = 0.9;
     tc_params[6].alpha = 0.1;
     tc_params[6].beta = 4;
@@ -112,6 +156,11 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[6].m_points = 20;
     tc_params[6].k_max = 30;
     tc_params[6].initial_velocity = 0.5;
+    tc_params[6].decomp = &griewangk_decomp;
+    tc_params[6].any_nd = 1;
+    tc_params[6].grad_est = GRAD_ANALYTIC;
+    tc_params[6].grad_step = D_INCR;
+    tc_params[6].spsa_draws = 1;
 
     /* Schaffer function */
     tc_params[7].nd = 2;
@@ -119,6 +168,8 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[7].high = 100;
     tc_params[7].goal = MIN_GOAL;
     tc_params[7].obj_func = schaffer;
+    tc_params[7].obj_func_batch = schaffer_batch;
+    tc_params[7].grad_func = schaffer_grad;
     tc_params[7].eta = 0.9;
     tc_params[7].alpha = 0.1;
     tc_params[7].beta = 4;
@@ -126,4 +177,76 @@ void init_tc_params(struct tc_params_s *tc_params)
     tc_params[7].m_points = 20;
     tc_params[7].k_max = 30;
     tc_params[7].initial_velocity = 0.5;
+    tc_params[7].decomp = NULL;
+    tc_params[7].any_nd = 0;
+    tc_params[7].grad_est = GRAD_ANALYTIC;
+    tc_params[7].grad_step = D_INCR;
+    tc_params[7].spsa_draws = 1;
+
+    /* Rastrigin function with variable evaluation cost (five decision
+     * variables). Scalar objective function only (no batched version, no
+     * analytic gradient). */
+    tc_params[8].nd = 5;
+    tc_params[8].low = -20;
+    tc_params[8].high = 20;
+    tc_params[8].goal = MIN_GOAL;
+    tc_params[8].obj_func = variable_cost;
+    tc_params[8].obj_func_batch = NULL;
+    tc_params[8].grad_func = NULL;
+    tc_params[8].eta = 0.9;
+    tc_params[8].alpha = 0.1;
+    tc_params[8].beta = 4;
+    tc_params[8].delta_t = 1;
+    tc_params[8].m_points = 20;
+    tc_params[8].k_max = 30;
+    tc_params[8].initial_velocity = 0.5;
+    tc_params[8].decomp = NULL;
+    tc_params[8].any_nd = 1;
+    tc_params[8].grad_est = GRAD_CENTRAL;
+    tc_params[8].grad_step = D_INCR;
+    tc_params[8].spsa_draws = 1;
+}
+
+/*
+ * This function initializes the parameters of a test case whose objective
+ * function is given at run time (expression, expr_set_active(), or simulator
+ * workers, sim_set_active()). The SSO parameters are those of the Rastrigin
+ * and Griewangk test cases.
+ *
+ * Input parameters
+ * - obj_func: objective function
+ * - obj_func_batch: batched objective function
+ * - nd: number of decision variables
+ * - low: decision variables lower bound
+ * - high: decision variables upper bound
+ * - goal: MIN_GOAL / MAX_GOAL
+ *
+ * Output parameters
+ * - tc_params: test case parameters
+ */
+void init_func_tc_params(struct tc_params_s *tc_params,
+                         num_t (*obj_func)(num_t *, int),
+                         void (*obj_func_batch)(num_t *, int, int, int,
+                                                num_t *),
+                         int nd, num_t low, num_t high, int goal)
+{
+    tc_params->nd = nd;
+    tc_params->low = low;
+    tc_params->high = high;
+    tc_params->goal = goal;
+    tc_params->obj_func = obj_func;
+    tc_params->obj_func_batch = obj_func_batch;
+    tc_params->grad_func = NULL;
+    tc_params->eta = 0.9;
+    tc_params->alpha = 0.1;
+    tc_params->beta = 4;
+    tc_params->delta_t = 1;
+    tc_params->m_points = 20;
+    tc_params->k_max = 30;
+    tc_params->initial_velocity = 0.5;
+    tc_params->decomp = NULL;
+    tc_params->any_nd = 1;
+    tc_params->grad_est = GRAD_CENTRAL;
+    tc_params->grad_step = D_INCR;
+    tc_params->spsa_draws = 1;
 }
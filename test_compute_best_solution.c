@@ -1,7 +1,9 @@
 /* Application used to test the compute_best_solution function
  * Compile with:
- * mpicc -Wall -g -lm test_compute_best_solution.c compute_best_solution.c
- * init_positions.c of.c tc.c utils.c -o test_compute_best_solution
+ * mpicc -Wall -g -fopenmp -lm test_compute_best_solution.c compute_best_solution.c
+ * kernels.c cache.c grad.c init_positions.c of.c tc.c utils.c rng.c exchange.c
+ * reduce_ops.c options.c prof.c checkpoint.c stop.c expr.c sim.c
+ * -o test_compute_best_solution
  *
  * Check for memory leaks with valgrind:
  * valgrind --leak-check=yes ./test_compute_best_solution
@@ -17,64 +19,71 @@
 
 int main()
 {
-    num_t **X;
+    struct population_s pop = {0};
     int np = 10;
     int nd = 2;
     num_t *best_solution;
     num_t best_val;
     struct tc_params_s tc_params[NUM_OF_TC]; /* Test cases parameters array */
+    struct run_opts_s opts;                  /* run options (defaults) */
 
-    /* Seed the PRNG */
-    srand(time(NULL));
-
-    /* Allocate a 2d matrix */
-    allocate_2d_matrix(&X, np, nd);
 
     /* Allocate space for the solution vector */
     best_solution = (num_t *)malloc(nd * sizeof(num_t));
 
     /* Initialize test case parameters array */
     init_tc_params(tc_params);
+    init_run_opts(&opts);
+
+    /* Allocate the population (all test cases below share nd, so the same
+     * arena is reused) */
+    population_alloc(&pop, np, nd, 0);
+    pop.offset = 0;
+    pop.seed = (uint64_t)time(NULL);
 
     /* Minimization of an ellpitic paraboloid function */
     printf("Minimization of an elliptic paraboloid function\n");
-    init_positions(X, np, tc_params[0].nd, tc_params[0].low, tc_params[0].high);
+    init_positions(&pop, tc_params[0].low, tc_params[0].high);
     // printf("Initial positions:\n");
-    // print_matrix(0, X, np, nd);
-    compute_best_solution(tc_params[0], X, np, best_solution, &best_val);
+    // print_matrix(0, pop.X, np, nd);
+    compute_best_solution(tc_params[0], &pop, &opts, MPI_COMM_SELF,
+                          best_solution, &best_val, NULL);
     printf("Best solution: [%f, %f]\n", best_solution[0], best_solution[1]);
     printf("Minimum value: %f\n\n", best_val);
 
     /* Minimization of Goldstein-Price function */
     printf("Minimization of Goldstein-Price function\n");
-    init_positions(X, np, tc_params[1].nd, tc_params[1].low, tc_params[1].high);
+    init_positions(&pop, tc_params[1].low, tc_params[1].high);
     // printf("Initial positions:\n");
-    // print_matrix(0, X, np, nd);
-    compute_best_solution(tc_params[1], X, np, best_solution, &best_val);
+    // print_matrix(0, pop.X, np, nd);
+    compute_best_solution(tc_params[1], &pop, &opts, MPI_COMM_SELF,
+                          best_solution, &best_val, NULL);
     printf("Best solution: [%f, %f]\n", best_solution[0], best_solution[1]);
     printf("Minimum value: %f\n\n", best_val);
 
     /* Maximization of "flipped" Goldstein-Price function */
     printf("Maximization of \"flipped\" of Goldstein-Price function\n");
-    init_positions(X, np, tc_params[2].nd, tc_params[2].low, tc_params[2].high);
+    init_positions(&pop, tc_params[2].low, tc_params[2].high);
     // printf("Initial positions:\n");
-    // print_matrix(0, X, np, nd);
-    compute_best_solution(tc_params[2], X, np, best_solution, &best_val);
+    // print_matrix(0, pop.X, np, nd);
+    compute_best_solution(tc_params[2], &pop, &opts, MPI_COMM_SELF,
+                          best_solution, &best_val, NULL);
     printf("Best solution: [%f, %f]\n", best_solution[0], best_solution[1]);
     printf("Maximum value: %f\n\n", best_val);
 
     /* Minimization of Rastrigin function */
     printf("Minimization of Rastrigin function (two decision variables)\n");
-    init_positions(X, np, tc_params[3].nd, tc_params[3].low, tc_params[3].high);
+    init_positions(&pop, tc_params[3].low, tc_params[3].high);
     // printf("Initial positions:\n");
-    // print_matrix(0, X, np, nd);
-    compute_best_solution(tc_params[3], X, np, best_solution, &best_val);
+    // print_matrix(0, pop.X, np, nd);
+    compute_best_solution(tc_params[3], &pop, &opts, MPI_COMM_SELF,
+                          best_solution, &best_val, NULL);
     printf("\nBest solution: [%f, %f]\n", best_solution[0], best_solution[1]);
     printf("Minimum value: %f\n\n", best_val);
 
     /* Free heap space */
     free(best_solution);
-    free_2d_matrix(&X, np);
+    population_free(&pop);
 
     return 0;
 }
@@ -0,0 +1,60 @@
+/* Application used to test the counter-based PRNG in rng.c
+ * Compile with:
+ * mpicc -Wall -g -fopenmp -lm test_rng.c rng.c utils.c -o test_rng
+ *
+ * (C) 2021 Giuseppe Vitolo
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sso.h"
+
+/* Number of draws */
+#define N 10
+
+int main()
+{
+    /* Philox4x32-10 known answer tests (Random123) */
+    uint32_t ctr[3][4] = {{0, 0, 0, 0},
+                          {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                          {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    uint32_t key[3][2] = {{0, 0},
+                          {0xffffffff, 0xffffffff},
+                          {0xa4093822, 0x299f31d0}};
+    uint32_t expected[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                               {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                               {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+    uint32_t out[4];
+    num_t bulk[N];
+    num_t single;
+    int i, j, ok;
+
+    printf("*** PRNG test application ***\n\n");
+
+    printf("Testing Philox4x32-10 known answers\n");
+    for (i = 0; i < 3; i++) {
+        philox4x32(ctr[i], key[i], out);
+        ok = 1;
+        for (j = 0; j < 4; j++) {
+            ok = ok && out[j] == expected[i][j];
+        }
+        printf("KAT %d: %s\n", i, ok ? "ok" : "FAILED");
+    }
+    printf("Done\n\n");
+
+    printf("Testing bulk fill against single draws (seed 42, shark 7, "
+           "iteration 3)\n");
+    rng_fill_uniform(42, RNG_STREAM_R3, 7, 3, 2, N, bulk);
+    ok = 1;
+    for (i = 0; i < N; i++) {
+        single = rng_uniform(42, RNG_STREAM_R3, 7, 3, 2 + i);
+        ok = ok && single == bulk[i];
+    }
+    print_vector(0, bulk, N);
+    printf("Bulk fill matches single draws: %s\n", ok ? "yes" : "no");
+    printf("Done\n\n");
+
+    printf("*** END ***\n");
+    return 0;
+}
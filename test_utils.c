@@ -1,6 +1,6 @@
 /* Application used to test the utility functions in utils.c
  * Compile with:
- * mpicc -Wall -g -lm test_utils.c utils.c -o test_utils
+ * mpicc -Wall -g -fopenmp -lm test_utils.c utils.c rng.c -o test_utils
  *
  * Check for memory leaks with valgrind:
  * valgrind --leak-check=yes ./test_utils
@@ -10,6 +10,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
 
 #include "sso.h"
 
@@ -18,6 +20,38 @@
 #define N 4
 #define P 5
 
+/* Test function: f(x) = sum of i * x_i^2 */
+static num_t weighted_squares(num_t *X, int nd)
+{
+    int i;
+    num_t val = 0;
+
+    for (i = 0; i < nd; i++) {
+        val += i * X[i] * X[i];
+    }
+
+    return val;
+}
+
+/* Whether the arena and every position and velocity row start on a cache
+ * line */
+static int rows_aligned(const struct population_s *pop)
+{
+    int i;
+
+    if ((uintptr_t)pop->arena % CACHE_LINE != 0) {
+        return 0;
+    }
+    for (i = 0; i < pop->np; i++) {
+        if ((uintptr_t)pop->X[i] % CACHE_LINE != 0 ||
+            (uintptr_t)pop->V[i] % CACHE_LINE != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 int main()
 {
     int i, j, k;
@@ -26,6 +60,11 @@ int main()
     num_t *storage;
     num_t **matrix2d;
     num_t ***matrix3d;
+    struct population_s pop = {0};
+    void *arena;
+    struct grad_ws_s grad_ws;
+    num_t point[N] = {1, 2, 3, 4};
+    num_t grad[N];
 
     printf("*** Utility function test application ***\n\n");
 
@@ -73,10 +112,59 @@ int main()
     }
     printf("Done\n\n");
 
+    printf("Testing population allocation (per-shark records)\n");
+    population_alloc(&pop, M, N, 0);
+    for (i = 0; i < M; i++) {
+        for (j = 0; j < N; j++) {
+            pop.X[i][j] = i + j;
+            pop.V[i][j] = 10 + i + j;
+        }
+    }
+    printf("ld = %d, arena size = %zu\n", pop.ld, pop.arena_size);
+    print_matrix(0, pop.X, M, N);
+    print_matrix(0, pop.V, M, N);
+    printf("Done\n\n");
+
+    printf("Testing population reuse (structure-of-arrays layout)\n");
+    arena = pop.arena;
+    population_alloc(&pop, M - 1, N, POP_SOA);
+    printf("Arena reused: %s\n", pop.arena == arena ? "yes" : "no");
+    /* Rows shorter than a cache line are packed, but never straddle one */
+    printf("Rows within a cache line: %s\n",
+           CACHE_LINE % (pop.ld * sizeof(num_t)) == 0 &&
+                   (uintptr_t)pop.X[1] % (pop.ld * sizeof(num_t)) == 0
+               ? "yes"
+               : "no");
+    printf("V[0] follows X[M - 2]: %s\n",
+           pop.V[0] == pop.X[M - 2] + pop.ld ? "yes" : "no");
+    print_matrix(0, pop.X, M - 1, N);
+    printf("Done\n\n");
+
+    /* Rows of at least a cache line start on a cache line (both layouts) */
+    printf("Testing population alignment (%d bytes)\n", CACHE_LINE);
+    population_alloc(&pop, M, CACHE_LINE / sizeof(num_t) + 1, 0);
+    printf("Records aligned: %s\n", rows_aligned(&pop) ? "yes" : "no");
+    assert(rows_aligned(&pop));
+    population_alloc(&pop, M, CACHE_LINE / sizeof(num_t) + 1, POP_SOA);
+    printf("Structure-of-arrays rows aligned: %s\n",
+           rows_aligned(&pop) ? "yes" : "no");
+    assert(rows_aligned(&pop));
+    printf("Done\n\n");
+
+    printf("Testing gradient (expected: 0 4 12 24)\n");
+    gradient(weighted_squares, point, N, grad);
+    print_vector(0, grad, N);
+    gradient_ws_alloc(&grad_ws, N, 0);
+    gradient_ws(weighted_squares, point, N, &grad_ws, grad);
+    print_vector(0, grad, N);
+    gradient_ws_free(&grad_ws);
+    printf("Done\n\n");
+
     free(cont_matrix);
     free(storage);
     free_2d_matrix(&matrix2d, M);
     free_3d_matrix(&matrix3d, M, N);
+    population_free(&pop);
 
     printf("*** END ***\n");
     return 0;
@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 
 #include "sso.h"
 
@@ -202,54 +204,295 @@ void free_3d_matrix(num_t ****M, int m, int n)
     free(*M);
 }
 
+/*
+ * This function allocates a gradient workspace, so that gradient_ws() and
+ * the gradient estimators (grad.c) can be called repeatedly without
+ * performing any heap allocation.
+ *
+ * Input parameters
+ * - nd: number of decision variables
+ * - batch: maximum number of stencil points per batched evaluation (0 if
+ *   only gradient_ws() is used)
+ *
+ * Output parameters
+ * - ws: gradient workspace
+ *
+ * Return value
+ * It returns -1 if a memory allocation error occurred.
+ * It returns 1 on success.
+ */
+int gradient_ws_alloc(struct grad_ws_s *ws, int nd, int batch)
+{
+    ws->nd = nd;
+    ws->batch = MIN(batch, 2 * nd);
+    ws->stencil = NULL;
+    ws->vals = NULL;
+
+    ws->point = (num_t *)malloc(nd * sizeof(num_t));
+    if (ws->point == NULL) {
+        return -1;
+    }
+
+    if (ws->batch > 0) {
+        ws->stencil = (num_t *)malloc((size_t)ws->batch * nd * sizeof(num_t));
+        ws->vals = (num_t *)malloc(ws->batch * sizeof(num_t));
+        if (ws->stencil == NULL || ws->vals == NULL) {
+            gradient_ws_free(ws);
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * This function frees a gradient workspace.
+ *
+ * Input parameters
+ * - ws: gradient workspace
+ */
+void gradient_ws_free(struct grad_ws_s *ws)
+{
+    free(ws->point);
+    free(ws->stencil);
+    free(ws->vals);
+    ws->point = NULL;
+    ws->stencil = NULL;
+    ws->vals = NULL;
+}
+
 /*
  * This function computes the numerical gradient of a function at a given point
- * using central difference approximation.
+ * using central difference approximation. The point is copied once into the
+ * workspace, then each coordinate is perturbed and restored in place.
  *
  * Input parameters
  * - f: function
  * - X: input variables (decision variables) vector
  * - nd: number of decision variables
+ * - ws: gradient workspace (allocated for at least nd decision variables)
  *
  * Output parameters
  * -result: computed gradient
+ */
+void gradient_ws(num_t (*f)(num_t *, int), num_t *X, int nd,
+                 struct grad_ws_s *ws, num_t *result)
+{
+    int i;
+    num_t *point = ws->point; /* perturbed point */
+    num_t f_right;            /* f(x + h) */
+
+    memcpy(point, X, nd * sizeof(num_t));
+
+    /* Compute each gradient component */
+    for (i = 0; i < nd; i++) {
+        point[i] = X[i] + D_INCR;
+        f_right = f(point, nd);
+
+        point[i] = X[i] - D_INCR;
+        result[i] = (f_right - f(point, nd)) / (2.0 * D_INCR);
+
+        point[i] = X[i];
+    }
+}
+
+/*
+ * This function copies a point into the rows of a stencil (once per
+ * gradient, see gradient_stencil()).
+ *
+ * Input parameters
+ * - X: input variables (decision variables) vector
+ * - nd: number of decision variables
+ * - rows: number of rows
+ *
+ * Output parameters
+ * - stencil: rows rows of nd, all equal to X
+ */
+void gradient_stencil_fill(num_t *X, int nd, int rows, num_t *stencil)
+{
+    int r;
+
+    for (r = 0; r < rows; r++) {
+        memcpy(&stencil[(size_t)r * nd], X, nd * sizeof(num_t));
+    }
+}
+
+/*
+ * This function builds the central difference stencil of n consecutive
+ * gradient components in place: rows 2q and 2q+1 (equal to X, see
+ * gradient_stencil_fill()) become x + h and x - h along component first + q.
+ * Only the perturbed components are written; gradient_stencil_restore()
+ * resets them once the points have been evaluated.
+ *
+ * Input parameters
+ * - X: input variables (decision variables) vector
+ * - nd: number of decision variables
+ * - first: first gradient component
+ * - n: number of gradient components
+ * - h: step
+ *
+ * Output parameters
+ * - stencil: stencil points (2 * n rows of nd)
+ */
+void gradient_stencil(num_t *X, int nd, int first, int n, double h,
+                      num_t *stencil)
+{
+    int q;
+    num_t *right; /* x + h stencil point */
+
+    for (q = 0; q < n; q++) {
+        right = &stencil[(size_t)(2 * q) * nd];
+        right[first + q] = X[first + q] + h;
+        right[nd + first + q] = X[first + q] - h;
+    }
+}
+
+/*
+ * This function resets the components perturbed by gradient_stencil(), so
+ * that the rows of the stencil are equal to X again.
+ *
+ * Input parameters
+ * - X: input variables (decision variables) vector
+ * - nd: number of decision variables
+ * - first: first gradient component
+ * - n: number of gradient components
+ *
+ * Output parameters
+ * - stencil: stencil points (2 * n rows of nd)
+ */
+void gradient_stencil_restore(num_t *X, int nd, int first, int n,
+                              num_t *stencil)
+{
+    int q;
+    num_t *right; /* x + h stencil point */
+
+    for (q = 0; q < n; q++) {
+        right = &stencil[(size_t)(2 * q) * nd];
+        right[first + q] = X[first + q];
+        right[nd + first + q] = X[first + q];
+    }
+}
+
+/*
+ * This function evaluates the objective function of a test case at n points.
+ * The batched objective function is used if available, otherwise the scalar
+ * one is called once per point.
+ *
+ * Input parameters
+ * - tc_params: test case parameters
+ * - X: n input variables vectors, one every ld elements
+ * - n: number of vectors
+ * - ld: distance (number of elements) between consecutive vectors
+ *
+ * Output parameters
+ * - result: objective function values (length: n)
+ */
+void eval_batch(const struct tc_params_s *tc_params, num_t *X, int n, int ld,
+                num_t *result)
+{
+    int p;
+
+    if (tc_params->obj_func_batch != NULL) {
+        tc_params->obj_func_batch(X, n, tc_params->nd, ld, result);
+        return;
+    }
+
+    for (p = 0; p < n; p++) {
+        result[p] = tc_params->obj_func(&X[(size_t)p * ld], tc_params->nd);
+    }
+}
+
+/*
+ * This function compares the analytic gradient of a test case with the
+ * central difference approximation at n_points points randomly sampled from
+ * the [low, high] hypercube (point p is drawn from stream RNG_STREAM_CHECK
+ * with index first + p). The error of each component is relative to the
+ * magnitude of the numerical derivative (absolute when it is smaller than 1).
+ *
+ * Input parameters
+ * - tc_params: test case parameters (grad_func must be set)
+ * - seed: PRNG seed
+ * - first: index of the first point
+ * - n_points: number of sampled points
+ *
+ * Output parameters
+ * - max_err: maximum error
  *
  * Return value
  * It returns -1 if a memory allocation error occurred.
- * It retuns 1 on success.
+ * It returns 1 on success.
  */
-int gradient(num_t (*f)(num_t *, int), num_t *X, int nd, num_t *result)
+int check_gradient(const struct tc_params_s *tc_params, uint64_t seed,
+                   int first, int n_points,
+                   num_t *max_err)
 {
-    int i;
-    num_t *current_X_right; /* x + h*/
-    num_t *current_X_left;  /* x - h*/
-
-    /* Allocate current_X_right */
-    current_X_right = (num_t *)malloc(nd * sizeof(num_t));
-    if (current_X_right == NULL) {
+    int p, j;
+    int nd = tc_params->nd;
+    num_t *point;    /* sampled point */
+    num_t *analytic; /* analytic gradient */
+    num_t *numeric;  /* numerical gradient */
+    num_t err;
+
+    point = (num_t *)malloc(3 * nd * sizeof(num_t));
+    if (point == NULL) {
         return -1;
     }
+    analytic = point + nd;
+    numeric = analytic + nd;
+
+    *max_err = 0;
+    for (p = 0; p < n_points; p++) {
+        rng_fill_uniform(seed, RNG_STREAM_CHECK, (uint32_t)(first + p), 0, 0,
+                         nd, point);
+        for (j = 0; j < nd; j++) {
+            point[j] = tc_params->low +
+                       (tc_params->high - tc_params->low) * point[j];
+        }
 
-    /* Allocate current_X_left */
-    current_X_left = (num_t *)malloc(nd * sizeof(num_t));
-    if (current_X_left == NULL) {
-        return -1;
+        tc_params->grad_func(point, nd, analytic);
+        if (gradient(tc_params->obj_func, point, nd, numeric) == -1) {
+            free(point);
+            return -1;
+        }
+
+        for (j = 0; j < nd; j++) {
+            err = fabs(analytic[j] - numeric[j]) / MAX(1.0, fabs(numeric[j]));
+            *max_err = MAX(*max_err, err);
+        }
     }
 
-    /* Compute each gradient component */
-    for (i = 0; i < nd; i++) {
-        memcpy(current_X_right, X, nd * sizeof(num_t));
-        memcpy(current_X_left, X, nd * sizeof(num_t));
+    free(point);
 
-        current_X_right[i] = X[i] + D_INCR;
-        current_X_left[i] = X[i] - D_INCR;
+    return 1;
+}
+
+/*
+ * This function computes the numerical gradient of a function at a given point
+ * using central difference approximation. It allocates a temporary workspace:
+ * use gradient_ws() on hot paths.
+ *
+ * Input parameters
+ * - f: function
+ * - X: input variables (decision variables) vector
+ * - nd: number of decision variables
+ *
+ * Output parameters
+ * -result: computed gradient
+ *
+ * Return value
+ * It returns -1 if a memory allocation error occurred.
+ * It retuns 1 on success.
+ */
+int gradient(num_t (*f)(num_t *, int), num_t *X, int nd, num_t *result)
+{
+    struct grad_ws_s ws;
 
-        result[i] = (f(current_X_right, nd) - f(current_X_left, nd)) / (2.0 * D_INCR);
+    if (gradient_ws_alloc(&ws, nd, 0) == -1) {
+        return -1;
     }
 
-    /* Free heap space */
-    free(current_X_right);
-    free(current_X_left);
+    gradient_ws(f, X, nd, &ws, result);
+    gradient_ws_free(&ws);
 
     return 1;
 }
@@ -273,3 +516,267 @@ int min_abs(num_t a, num_t b)
         return 1;
     }
 }
+
+/*
+ * This function returns the number of elements between the beginning of two
+ * consecutive rows of nd elements. Rows are padded so that they never straddle
+ * a cache line: short rows are padded to a power of two that divides the cache
+ * line size, long rows to a multiple of the cache line size.
+ *
+ * Input parameters
+ * - nd: number of elements in a row
+ *
+ * Return value
+ * Row stride (leading dimension) in elements.
+ */
+static int row_stride(int nd)
+{
+    int per_line = CACHE_LINE / sizeof(num_t);
+    int ld = 1;
+
+    if (nd >= per_line) {
+        return ((nd + per_line - 1) / per_line) * per_line;
+    }
+
+    while (ld < nd) {
+        ld *= 2;
+    }
+
+    return ld;
+}
+
+/* Round n up to a multiple of a (a must be a power of two) */
+static size_t round_up(size_t n, size_t a)
+{
+    return (n + a - 1) & ~(a - 1);
+}
+
+/*
+ * This function returns the size of the arena of a population.
+ *
+ * Input parameters
+ * - np: population size
+ * - nd: number of decision variables
+ * - flags: POP_* (see population_alloc())
+ *
+ * Return value
+ * It returns the arena size (bytes).
+ */
+size_t population_size(int np, int nd, int flags)
+{
+    size_t ptrs_size;  /* row pointers size (bytes) */
+    size_t vals_size;  /* best_OF_vals size (bytes) */
+    size_t row_size;   /* padded row size (bytes) */
+    size_t rec_size;   /* shark record size (bytes, default layout) */
+    size_t size;       /* total arena size (bytes) */
+
+    row_size = (size_t)row_stride(nd) * sizeof(num_t);
+    rec_size = round_up(2 * row_size, CACHE_LINE);
+    ptrs_size = round_up((size_t)np * 2 * sizeof(num_t *), CACHE_LINE);
+    vals_size = round_up((size_t)np * sizeof(num_t), CACHE_LINE);
+
+    if (flags & POP_SOA) {
+        size = ptrs_size + vals_size +
+               2 * round_up((size_t)np * row_size, CACHE_LINE);
+    } else {
+        size = ptrs_size + vals_size + (size_t)np * rec_size;
+    }
+
+    return round_up(size, (flags & POP_HUGEPAGES) ? HUGE_PAGE : CACHE_LINE);
+}
+
+/*
+ * This function sets up a population inside a single aligned memory block
+ * (arena). Positions (X), velocities (V) and the per-shark best objective
+ * function values all live in the arena, together with the row pointers used
+ * to access them, so no other allocation is needed. Candidate positions are
+ * not part of the population: they are generated in a per-thread scratch
+ * buffer (see compute_best_solution()).
+ * With the default layout each shark owns a contiguous record (X and V
+ * rows). With POP_SOA each field is stored as a contiguous block of rows.
+ * If the population already owns an arena which is large enough (and has been
+ * allocated with the same POP_HUGEPAGES flag), the arena is reused and no
+ * allocation takes place. The population structure must be zero-initialized
+ * before the first call. With POP_SHARED the arena (arena, arena_size and
+ * flags fields) is provided by the caller and is never reallocated.
+ *
+ * Input parameters
+ * - np: population size
+ * - nd: number of decision variables
+ * - flags: POP_SOA, POP_HUGEPAGES and/or POP_SHARED (0 for defaults)
+ *
+ * Output parameters
+ * - pop: population
+ *
+ * Return value
+ * It returns -1 if a memory allocation problem occurred (POP_SHARED: the
+ * arena is too small).
+ * It returns 1 on success.
+ */
+int population_alloc(struct population_s *pop, int np, int nd, int flags)
+{
+    size_t ptrs_size;  /* row pointers size (bytes) */
+    size_t vals_size;  /* best_OF_vals size (bytes) */
+    size_t row_size;   /* padded row size (bytes) */
+    size_t rec_size;   /* shark record size (bytes, default layout) */
+    size_t size;       /* total arena size (bytes) */
+    size_t align;      /* arena alignment */
+    char *base;        /* arena data base address */
+    int ld;            /* leading dimension */
+    int i;
+
+    ld = row_stride(nd);
+    row_size = (size_t)ld * sizeof(num_t);
+    rec_size = round_up(2 * row_size, CACHE_LINE);
+    ptrs_size = round_up((size_t)np * 2 * sizeof(num_t *), CACHE_LINE);
+    vals_size = round_up((size_t)np * sizeof(num_t), CACHE_LINE);
+    size = population_size(np, nd, flags);
+    align = (flags & POP_HUGEPAGES) ? HUGE_PAGE : CACHE_LINE;
+
+    /* A shared arena cannot be replaced */
+    if ((flags & POP_SHARED) &&
+        (pop->arena == NULL || pop->arena_size < size)) {
+        return -1;
+    }
+
+    /* Reuse the current arena if possible */
+    if (pop->arena != NULL && (pop->arena_size < size ||
+        (pop->flags & POP_HUGEPAGES) != (flags & POP_HUGEPAGES))) {
+        population_free(pop);
+    }
+
+    if (pop->arena == NULL) {
+        if (posix_memalign(&pop->arena, align, size) != 0) {
+            pop->arena = NULL;
+            return -1;
+        }
+        pop->arena_size = size;
+#ifdef MADV_HUGEPAGE
+        if (flags & POP_HUGEPAGES) {
+            madvise(pop->arena, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    pop->np = np;
+    pop->nd = nd;
+    pop->ld = ld;
+    pop->flags = flags;
+
+    /* Row pointers */
+    base = (char *)pop->arena;
+    pop->X = (num_t **)base;
+    pop->V = pop->X + np;
+    base += ptrs_size;
+
+    pop->best_OF_vals = (num_t *)base;
+    base += vals_size;
+
+    for (i = 0; i < np; i++) {
+        if (flags & POP_SOA) {
+            pop->X[i] = (num_t *)(base + i * row_size);
+            pop->V[i] = (num_t *)(base + round_up(np * row_size, CACHE_LINE) +
+                                  i * row_size);
+        } else {
+            pop->X[i] = (num_t *)(base + i * rec_size);
+            pop->V[i] = (num_t *)(base + i * rec_size + row_size);
+        }
+    }
+
+    population_reset(pop);
+
+    return 1;
+}
+
+/*
+ * This function clears the state (positions, velocities and objective
+ * function values) of a population, without releasing its memory. Only the
+ * part of the arena used by the current np and nd is cleared (a reused arena
+ * may be larger).
+ *
+ * Input parameters
+ * - pop: population
+ */
+void population_reset(struct population_s *pop)
+{
+    size_t ptrs_size;
+    size_t size;
+
+    ptrs_size = round_up((size_t)pop->np * 2 * sizeof(num_t *), CACHE_LINE);
+    size = population_size(pop->np, pop->nd, pop->flags & ~POP_HUGEPAGES);
+    memset((char *)pop->arena + ptrs_size, 0, size - ptrs_size);
+}
+
+/*
+ * This function frees the arena owned by a population (not a POP_SHARED
+ * one).
+ *
+ * Input parameters
+ * - pop: population
+ */
+void population_free(struct population_s *pop)
+{
+    if (!(pop->flags & POP_SHARED)) {
+        free(pop->arena);
+    }
+    memset(pop, 0, sizeof(*pop));
+}
+
+/*
+ * This function returns the calling thread number inside a parallel region
+ * (0 if OpenMP is not enabled).
+ */
+int thread_num(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/*
+ * This function returns the number of threads used by the next parallel
+ * region (1 if OpenMP is not enabled).
+ */
+int max_threads(void)
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/*
+ * This function sets the number of threads used by parallel regions (it has
+ * no effect if OpenMP is not enabled).
+ *
+ * Input parameters
+ * - n: number of threads
+ */
+void set_num_threads(int n)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(n);
+#else
+    (void)n;
+#endif
+}
+
+/*
+ * This function returns the peak resident set size of the calling process.
+ *
+ * Return value
+ * Peak resident set size (KiB), 0 if not available.
+ */
+long peak_rss(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    return usage.ru_maxrss; /* KiB on Linux */
+}